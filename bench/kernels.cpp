@@ -0,0 +1,253 @@
+// Throughput of the R-free detection, zenith and model kernels.
+//
+// Each case is run repeatedly for at least MIN_SECONDS, and reports the mean
+// points per second and the peak resident memory of the process so far, which
+// is that of the largest series run yet.
+//
+// Build from the package root with the flags of src/Makevars, all on one line:
+//
+//     g++ -std=c++11 -O2 -pthread -ftree-vectorize -fno-math-errno
+//         -fno-trapping-math -Isrc -o bench/kernels bench/kernels.cpp
+//         src/window.cpp src/criterion.cpp src/solar_vec.cpp src/solar_fast.cpp
+//         src/models_vec.cpp
+//
+// Usage: bench/kernels [--quick] [filter]. --quick leaves out the 10 year
+// series, and only cases whose name contains filter are run.
+
+#include <algorithm>   // copy
+#include <chrono>
+#include <stdio.h>
+#include <string.h>    // strcmp, strstr
+#include <string>
+#include <vector>
+#include <sys/resource.h>  // getrusage
+#include "detect.h"
+#include "models.h"
+#include "solar.h"
+
+const double MIN_SECONDS = 0.25;
+
+// Series lengths, in days, and intervals, in minutes.
+const int DAYS[] = {1, 30, 365, 3650};
+const int INTERVALS[] = {1, 5, 15, 60};
+const int WINDOW_LENS[] = {5, 10, 30, 60};
+
+// julian day of 2014-01-01, as calc_julian_day
+const double JULDAY_2014 = 56658.5;
+
+// Peak resident memory, in MB.
+double peak_mb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;
+}
+
+// Mean seconds per call of f, called until MIN_SECONDS have passed.
+template <typename F>
+double time_calls(F f) {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    int calls = 0;
+    double elapsed;
+    do {
+        f();
+        ++calls;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < MIN_SECONDS);
+    return elapsed / calls;
+}
+
+void report(const char *name, int days, int interval, int window_len, long n,
+            double seconds) {
+    printf("%-16s %6d %9d %7d %10ld %10.4f %12.2f %9.1f\n", name, days, interval,
+           window_len, n, seconds, n / seconds / 1e6, peak_mb());
+    fflush(stdout);
+}
+
+// Universal time of each interval of a day, as universal_gmt in UTC.
+std::vector<double> day_times(int interval) {
+    int n = 1440 / interval;
+    std::vector<double> utime(n);
+    for (int i = 0; i < n; ++i) {
+        utime[i] = (double) i * interval / 60;
+    }
+    return utime;
+}
+
+// Clear sky and observed irradiance for days of interval minutes: the RS
+// model at Eugene, Oregon, and the same with pseudo-random passing clouds.
+void synthetic_series(int days, int interval, std::vector<double> &x,
+                      std::vector<double> &cs) {
+    std::vector<double> utime = day_times(interval);
+    Location loc(44.05, -123.07);
+    RSModel model = {1159.24, 1.179, -0.0019};
+
+    long n = (long) days * utime.size();
+    x.resize(n);
+    cs.resize(n);
+    unsigned int state = 1;
+    double cloud = 1;
+    for (long i = 0; i < n; ++i) {
+        int d = i / utime.size();
+        double z = solar_zenith(solar_ephemeris(JULDAY_2014 + d, utime[i % utime.size()]), loc);
+        cs[i] = model(z, 0);
+
+        // clouds come and go every hour or so
+        state = state * 1103515245 + 12345;
+        if ((state >> 16) % (60 / interval + 1) == 0) {
+            cloud = ((state >> 8) & 0xff) < 96 ? 0.4 + (state & 0xff) / 512.0 : 1;
+        }
+        x[i] = cs[i] * cloud;
+    }
+}
+
+// Reno et al thresholds, as in the thresholds dataset.
+Thresholds reno_thresholds() {
+    double lower[N_CRITERION] = {-75, -75, -5, 0, 0};
+    double upper[N_CRITERION] = {75, 75, 10, 0.005, 8};
+    return Thresholds(lower, upper);
+}
+
+bool never_stop() { return false; }
+
+void bench_detection(int days, int interval, bool wanted_double, bool wanted_float) {
+    std::vector<double> x, cs;
+    synthetic_series(days, interval, x, cs);
+    long n = x.size();
+
+    std::vector<float> xf(x.begin(), x.end()), csf(cs.begin(), cs.end());
+    std::vector<unsigned char> clear(n);
+    Thresholds thresholds = reno_thresholds();
+
+    for (size_t w = 0; w < sizeof(WINDOW_LENS) / sizeof(int); ++w) {
+        int window_len = WINDOW_LENS[w];
+        if (window_len > n) continue;
+        long last = n - window_len + 1;
+
+        if (wanted_double) {
+            double seconds = time_calls([&]() {
+                detect_clear(x.data(), cs.data(), 0, last, window_len, thresholds,
+                             clear.data(), never_stop);
+            });
+            report("detect", days, interval, window_len, n, seconds);
+        }
+        if (wanted_float) {
+            double seconds = time_calls([&]() {
+                detect_clear(xf.data(), csf.data(), 0, last, window_len, thresholds,
+                             clear.data(), never_stop);
+            });
+            report("detect_float32", days, interval, window_len, n, seconds);
+        }
+    }
+}
+
+void bench_zenith(int days, int interval, bool wanted_scalar, bool wanted_vectorized,
+                  bool wanted_fast, bool wanted_model, bool wanted_model_vec) {
+    std::vector<double> utime = day_times(interval);
+    int n_times = utime.size();
+    long n = (long) days * n_times;
+    std::vector<double> zenith(n);
+    Location loc(44.05, -123.07);
+
+    if (wanted_scalar) {
+        double seconds = time_calls([&]() {
+            for (int d = 0; d < days; ++d) {
+                for (int t = 0; t < n_times; ++t) {
+                    zenith[(long) d * n_times + t] =
+                        solar_zenith(solar_ephemeris(JULDAY_2014 + d, utime[t]), loc);
+                }
+            }
+        });
+        report("zenith", days, interval, 0, n, seconds);
+    }
+
+    if (wanted_vectorized) {
+        double seconds = time_calls([&]() {
+            for (int d = 0; d < days; ++d) {
+                solar_zenith_vectorized(JULDAY_2014 + d, utime.data(), n_times, loc,
+                                        zenith.data() + (long) d * n_times);
+            }
+        });
+        report("zenith_vec", days, interval, 0, n, seconds);
+    }
+
+    if (wanted_fast) {
+        double seconds = time_calls([&]() {
+            for (int d = 0; d < days; ++d) {
+                solar_zenith_fast(JULDAY_2014 + d, utime.data(), n_times, loc,
+                                  zenith.data() + (long) d * n_times);
+            }
+        });
+        report("zenith_fast", days, interval, 0, n, seconds);
+    }
+
+    if (wanted_model) {
+        // Ineichen over precomputed zenith angles, as the models do
+        IneichenModel model(0.50572, 6.07995, 1.6364, 3, 150);
+        std::vector<double> ghi(n);
+        double seconds = time_calls([&]() {
+            for (int d = 0; d < days; ++d) {
+                double io = extraterrestrial(d % 365 + 1);
+                for (int t = 0; t < n_times; ++t) {
+                    long i = (long) d * n_times + t;
+                    ghi[i] = model(zenith[i], io);
+                }
+            }
+        });
+        report("ineichen", days, interval, 0, n, seconds);
+    }
+
+    if (wanted_model_vec) {
+        IneichenModel model(0.50572, 6.07995, 1.6364, 3, 150);
+        std::vector<double> ghi(n);
+        double seconds = time_calls([&]() {
+            std::copy(zenith.begin(), zenith.end(), ghi.begin());
+            for (int d = 0; d < days; ++d) {
+                model_vectorized(model, extraterrestrial(d % 365 + 1),
+                                 ghi.data() + (long) d * n_times, n_times);
+            }
+        });
+        report("ineichen_vec", days, interval, 0, n, seconds);
+    }
+}
+
+int main(int argc, char **argv) {
+    bool quick = false;
+    std::string filter;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            quick = true;
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    // case names containing filter
+    struct Wanted {
+        std::string filter;
+        bool operator()(const char *name) const {
+            return filter.empty() || strstr(name, filter.c_str()) != 0;
+        }
+    } wanted = {filter};
+
+    printf("%-16s %6s %9s %7s %10s %10s %12s %9s\n", "case", "days", "interval",
+           "window", "points", "seconds", "Mpoints/s", "peak_MB");
+
+    for (size_t d = 0; d < sizeof(DAYS) / sizeof(int); ++d) {
+        if (quick && DAYS[d] > 365) continue;
+        for (size_t i = 0; i < sizeof(INTERVALS) / sizeof(int); ++i) {
+            if (wanted("zenith") || wanted("zenith_vec") || wanted("zenith_fast") ||
+                wanted("ineichen") || wanted("ineichen_vec")) {
+                bench_zenith(DAYS[d], INTERVALS[i], wanted("zenith"), wanted("zenith_vec"),
+                             wanted("zenith_fast"), wanted("ineichen"),
+                             wanted("ineichen_vec"));
+            }
+            if (wanted("detect") || wanted("detect_float32")) {
+                bench_detection(DAYS[d], INTERVALS[i], wanted("detect"),
+                                wanted("detect_float32"));
+            }
+        }
+    }
+
+    return 0;
+}
@@ -1,13 +1,158 @@
 // This file was generated by Rcpp::compileAttributes
 // Generator token: 10BE3573-1514-4C36-9D1C-5A225CD40393
 
+#include "clearskies_types.h"
 #include <Rcpp.h>
 
 using namespace Rcpp;
 
+// compact_supported
+bool compact_supported();
+RcppExport SEXP clearskies_compact_supported() {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    __result = Rcpp::wrap(compact_supported());
+    return __result;
+END_RCPP
+}
+// is_compact
+bool is_compact(SEXP x);
+RcppExport SEXP clearskies_is_compact(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    __result = Rcpp::wrap(is_compact(x));
+    return __result;
+END_RCPP
+}
+// as_clearmask
+Rcpp::RawVector as_clearmask(Rcpp::LogicalVector x);
+RcppExport SEXP clearskies_as_clearmask(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< Rcpp::LogicalVector >::type x(xSEXP);
+    __result = Rcpp::wrap(as_clearmask(x));
+    return __result;
+END_RCPP
+}
+// mask_logical
+Rcpp::LogicalVector mask_logical(SEXP x, SEXP index);
+RcppExport SEXP clearskies_mask_logical(SEXP xSEXP, SEXP indexSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type index(indexSEXP);
+    __result = Rcpp::wrap(mask_logical(x, index));
+    return __result;
+END_RCPP
+}
+// mask_count
+double mask_count(SEXP x);
+RcppExport SEXP clearskies_mask_count(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    __result = Rcpp::wrap(mask_count(x));
+    return __result;
+END_RCPP
+}
+// mask_runs
+Rcpp::DataFrame mask_runs(SEXP x);
+RcppExport SEXP clearskies_mask_runs(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    __result = Rcpp::wrap(mask_runs(x));
+    return __result;
+END_RCPP
+}
+// mask_days
+Rcpp::NumericVector mask_days(SEXP x, double day_length);
+RcppExport SEXP clearskies_mask_days(SEXP xSEXP, SEXP day_lengthSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< double >::type day_length(day_lengthSEXP);
+    __result = Rcpp::wrap(mask_days(x, day_length));
+    return __result;
+END_RCPP
+}
 // clear_pts
-Rcpp::LogicalVector clear_pts(Rcpp::NumericVector x, Rcpp::NumericVector cs, Rcpp::List thresholds, int window_len);
-RcppExport SEXP clearskies_clear_pts(SEXP xSEXP, SEXP csSEXP, SEXP thresholdsSEXP, SEXP window_lenSEXP) {
+SEXP clear_pts(SEXP x, SEXP cs, Rcpp::List thresholds, int window_len, int threads, SEXP zenith, double min_elevation, bool profile, bool packed);
+RcppExport SEXP clearskies_clear_pts(SEXP xSEXP, SEXP csSEXP, SEXP thresholdsSEXP, SEXP window_lenSEXP, SEXP threadsSEXP, SEXP zenithSEXP, SEXP min_elevationSEXP, SEXP profileSEXP, SEXP packedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type cs(csSEXP);
+    Rcpp::traits::input_parameter< Rcpp::List >::type thresholds(thresholdsSEXP);
+    Rcpp::traits::input_parameter< int >::type window_len(window_lenSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type zenith(zenithSEXP);
+    Rcpp::traits::input_parameter< double >::type min_elevation(min_elevationSEXP);
+    Rcpp::traits::input_parameter< bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< bool >::type packed(packedSEXP);
+    __result = Rcpp::wrap(clear_pts(x, cs, thresholds, window_len, threads, zenith, min_elevation, profile, packed));
+    return __result;
+END_RCPP
+}
+// clear_pts_file
+double clear_pts_file(std::string path, Rcpp::List thresholds, int window_len, int threads, std::string observed, std::string predicted, std::string clear);
+RcppExport SEXP clearskies_clear_pts_file(SEXP pathSEXP, SEXP thresholdsSEXP, SEXP window_lenSEXP, SEXP threadsSEXP, SEXP observedSEXP, SEXP predictedSEXP, SEXP clearSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< Rcpp::List >::type thresholds(thresholdsSEXP);
+    Rcpp::traits::input_parameter< int >::type window_len(window_lenSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    Rcpp::traits::input_parameter< std::string >::type observed(observedSEXP);
+    Rcpp::traits::input_parameter< std::string >::type predicted(predictedSEXP);
+    Rcpp::traits::input_parameter< std::string >::type clear(clearSEXP);
+    __result = Rcpp::wrap(clear_pts_file(path, thresholds, window_len, threads, observed, predicted, clear));
+    return __result;
+END_RCPP
+}
+// criteria_matrix
+SEXP criteria_matrix(Rcpp::NumericVector x, Rcpp::NumericVector cs, int window_len, bool float32);
+RcppExport SEXP clearskies_criteria_matrix(SEXP xSEXP, SEXP csSEXP, SEXP window_lenSEXP, SEXP float32SEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type cs(csSEXP);
+    Rcpp::traits::input_parameter< int >::type window_len(window_lenSEXP);
+    Rcpp::traits::input_parameter< bool >::type float32(float32SEXP);
+    __result = Rcpp::wrap(criteria_matrix(x, cs, window_len, float32));
+    return __result;
+END_RCPP
+}
+// clear_pts_grouped
+Rcpp::LogicalVector clear_pts_grouped(SEXP x, SEXP cs, Rcpp::NumericVector offsets, Rcpp::List thresholds, int window_len, int threads);
+RcppExport SEXP clearskies_clear_pts_grouped(SEXP xSEXP, SEXP csSEXP, SEXP offsetsSEXP, SEXP thresholdsSEXP, SEXP window_lenSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type cs(csSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type offsets(offsetsSEXP);
+    Rcpp::traits::input_parameter< Rcpp::List >::type thresholds(thresholdsSEXP);
+    Rcpp::traits::input_parameter< int >::type window_len(window_lenSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    __result = Rcpp::wrap(clear_pts_grouped(x, cs, offsets, thresholds, window_len, threads));
+    return __result;
+END_RCPP
+}
+// clear_segments
+Rcpp::DataFrame clear_segments(Rcpp::NumericVector x, Rcpp::NumericVector cs, Rcpp::List thresholds, int window_len);
+RcppExport SEXP clearskies_clear_segments(SEXP xSEXP, SEXP csSEXP, SEXP thresholdsSEXP, SEXP window_lenSEXP) {
 BEGIN_RCPP
     Rcpp::RObject __result;
     Rcpp::RNGScope __rngScope;
@@ -15,7 +160,64 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< Rcpp::NumericVector >::type cs(csSEXP);
     Rcpp::traits::input_parameter< Rcpp::List >::type thresholds(thresholdsSEXP);
     Rcpp::traits::input_parameter< int >::type window_len(window_lenSEXP);
-    __result = Rcpp::wrap(clear_pts(x, cs, thresholds, window_len));
+    __result = Rcpp::wrap(clear_segments(x, cs, thresholds, window_len));
+    return __result;
+END_RCPP
+}
+// clear_pts_sweep
+Rcpp::LogicalMatrix clear_pts_sweep(Rcpp::NumericVector x, Rcpp::NumericVector cs, Rcpp::List threshold_sets, int window_len, SEXP criteria);
+RcppExport SEXP clearskies_clear_pts_sweep(SEXP xSEXP, SEXP csSEXP, SEXP threshold_setsSEXP, SEXP window_lenSEXP, SEXP criteriaSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type cs(csSEXP);
+    Rcpp::traits::input_parameter< Rcpp::List >::type threshold_sets(threshold_setsSEXP);
+    Rcpp::traits::input_parameter< int >::type window_len(window_lenSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type criteria(criteriaSEXP);
+    __result = Rcpp::wrap(clear_pts_sweep(x, cs, threshold_sets, window_len, criteria));
+    return __result;
+END_RCPP
+}
+// clear_detector
+Rcpp::XPtr<StreamingDetector> clear_detector(Rcpp::List thresholds, int window_len);
+RcppExport SEXP clearskies_clear_detector(SEXP thresholdsSEXP, SEXP window_lenSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< Rcpp::List >::type thresholds(thresholdsSEXP);
+    Rcpp::traits::input_parameter< int >::type window_len(window_lenSEXP);
+    __result = Rcpp::wrap(clear_detector(thresholds, window_len));
+    return __result;
+END_RCPP
+}
+// detector_push
+Rcpp::LogicalVector detector_push(Rcpp::XPtr<StreamingDetector> detector, Rcpp::NumericVector x, Rcpp::NumericVector cs, bool flush);
+RcppExport SEXP clearskies_detector_push(SEXP detectorSEXP, SEXP xSEXP, SEXP csSEXP, SEXP flushSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<StreamingDetector> >::type detector(detectorSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type cs(csSEXP);
+    Rcpp::traits::input_parameter< bool >::type flush(flushSEXP);
+    __result = Rcpp::wrap(detector_push(detector, x, cs, flush));
+    return __result;
+END_RCPP
+}
+// clear_pts_rescaled
+Rcpp::LogicalVector clear_pts_rescaled(SEXP x, SEXP cs, Rcpp::List thresholds, int window_len, int max_iter, double tolerance);
+RcppExport SEXP clearskies_clear_pts_rescaled(SEXP xSEXP, SEXP csSEXP, SEXP thresholdsSEXP, SEXP window_lenSEXP, SEXP max_iterSEXP, SEXP toleranceSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type cs(csSEXP);
+    Rcpp::traits::input_parameter< Rcpp::List >::type thresholds(thresholdsSEXP);
+    Rcpp::traits::input_parameter< int >::type window_len(window_lenSEXP);
+    Rcpp::traits::input_parameter< int >::type max_iter(max_iterSEXP);
+    Rcpp::traits::input_parameter< double >::type tolerance(toleranceSEXP);
+    __result = Rcpp::wrap(clear_pts_rescaled(x, cs, thresholds, window_len, max_iter, tolerance));
     return __result;
 END_RCPP
 }
@@ -31,31 +233,302 @@ BEGIN_RCPP
     return __result;
 END_RCPP
 }
+// write_columns
+void write_columns(std::string path, Rcpp::List columns, double interval, std::string model, bool append);
+RcppExport SEXP clearskies_write_columns(SEXP pathSEXP, SEXP columnsSEXP, SEXP intervalSEXP, SEXP modelSEXP, SEXP appendSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< Rcpp::List >::type columns(columnsSEXP);
+    Rcpp::traits::input_parameter< double >::type interval(intervalSEXP);
+    Rcpp::traits::input_parameter< std::string >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< bool >::type append(appendSEXP);
+    write_columns(path, columns, interval, model, append);
+    return R_NilValue;
+END_RCPP
+}
+// read_columns
+Rcpp::List read_columns(std::string path, SEXP names, bool packed);
+RcppExport SEXP clearskies_read_columns(SEXP pathSEXP, SEXP namesSEXP, SEXP packedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type names(namesSEXP);
+    Rcpp::traits::input_parameter< bool >::type packed(packedSEXP);
+    __result = Rcpp::wrap(read_columns(path, names, packed));
+    return __result;
+END_RCPP
+}
+// plot_points
+Rcpp::NumericVector plot_points(Rcpp::List series, SEXP clear, double max_points);
+RcppExport SEXP clearskies_plot_points(SEXP seriesSEXP, SEXP clearSEXP, SEXP max_pointsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< Rcpp::List >::type series(seriesSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type clear(clearSEXP);
+    Rcpp::traits::input_parameter< double >::type max_points(max_pointsSEXP);
+    __result = Rcpp::wrap(plot_points(series, clear, max_points));
+    return __result;
+END_RCPP
+}
 // exrad
-Rcpp::NumericVector exrad(Rcpp::NumericVector dayofyear, int times);
-RcppExport SEXP clearskies_exrad(SEXP dayofyearSEXP, SEXP timesSEXP) {
+SEXP exrad(Rcpp::NumericVector dayofyear, int times, bool compact);
+RcppExport SEXP clearskies_exrad(SEXP dayofyearSEXP, SEXP timesSEXP, SEXP compactSEXP) {
 BEGIN_RCPP
     Rcpp::RObject __result;
     Rcpp::RNGScope __rngScope;
     Rcpp::traits::input_parameter< Rcpp::NumericVector >::type dayofyear(dayofyearSEXP);
     Rcpp::traits::input_parameter< int >::type times(timesSEXP);
-    __result = Rcpp::wrap(exrad(dayofyear, times));
+    Rcpp::traits::input_parameter< bool >::type compact(compactSEXP);
+    __result = Rcpp::wrap(exrad(dayofyear, times, compact));
+    return __result;
+END_RCPP
+}
+// float32_to_double
+Rcpp::NumericVector float32_to_double(Rcpp::RawVector x);
+RcppExport SEXP clearskies_float32_to_double(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< Rcpp::RawVector >::type x(xSEXP);
+    __result = Rcpp::wrap(float32_to_double(x));
+    return __result;
+END_RCPP
+}
+// as_float32
+Rcpp::RawVector as_float32(Rcpp::NumericVector x);
+RcppExport SEXP clearskies_as_float32(SEXP xSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type x(xSEXP);
+    __result = Rcpp::wrap(as_float32(x));
+    return __result;
+END_RCPP
+}
+// abcg_model
+SEXP abcg_model(Rcpp::NumericVector dayofyear, Rcpp::NumericVector year, double tz, double latitude, double longitude, double interval, double a, double b, bool vectorized, bool float32, SEXP time, bool compact, bool fast);
+RcppExport SEXP clearskies_abcg_model(SEXP dayofyearSEXP, SEXP yearSEXP, SEXP tzSEXP, SEXP latitudeSEXP, SEXP longitudeSEXP, SEXP intervalSEXP, SEXP aSEXP, SEXP bSEXP, SEXP vectorizedSEXP, SEXP float32SEXP, SEXP timeSEXP, SEXP compactSEXP, SEXP fastSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type dayofyear(dayofyearSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type year(yearSEXP);
+    Rcpp::traits::input_parameter< double >::type tz(tzSEXP);
+    Rcpp::traits::input_parameter< double >::type latitude(latitudeSEXP);
+    Rcpp::traits::input_parameter< double >::type longitude(longitudeSEXP);
+    Rcpp::traits::input_parameter< double >::type interval(intervalSEXP);
+    Rcpp::traits::input_parameter< double >::type a(aSEXP);
+    Rcpp::traits::input_parameter< double >::type b(bSEXP);
+    Rcpp::traits::input_parameter< bool >::type vectorized(vectorizedSEXP);
+    Rcpp::traits::input_parameter< bool >::type float32(float32SEXP);
+    Rcpp::traits::input_parameter< SEXP >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< bool >::type compact(compactSEXP);
+    Rcpp::traits::input_parameter< bool >::type fast(fastSEXP);
+    __result = Rcpp::wrap(abcg_model(dayofyear, year, tz, latitude, longitude, interval, a, b, vectorized, float32, time, compact, fast));
     return __result;
 END_RCPP
 }
+// rs_model
+SEXP rs_model(Rcpp::NumericVector dayofyear, Rcpp::NumericVector year, double tz, double latitude, double longitude, double interval, double a, double b, double c, bool vectorized, bool float32, SEXP time, bool compact, bool fast);
+RcppExport SEXP clearskies_rs_model(SEXP dayofyearSEXP, SEXP yearSEXP, SEXP tzSEXP, SEXP latitudeSEXP, SEXP longitudeSEXP, SEXP intervalSEXP, SEXP aSEXP, SEXP bSEXP, SEXP cSEXP, SEXP vectorizedSEXP, SEXP float32SEXP, SEXP timeSEXP, SEXP compactSEXP, SEXP fastSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type dayofyear(dayofyearSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type year(yearSEXP);
+    Rcpp::traits::input_parameter< double >::type tz(tzSEXP);
+    Rcpp::traits::input_parameter< double >::type latitude(latitudeSEXP);
+    Rcpp::traits::input_parameter< double >::type longitude(longitudeSEXP);
+    Rcpp::traits::input_parameter< double >::type interval(intervalSEXP);
+    Rcpp::traits::input_parameter< double >::type a(aSEXP);
+    Rcpp::traits::input_parameter< double >::type b(bSEXP);
+    Rcpp::traits::input_parameter< double >::type c(cSEXP);
+    Rcpp::traits::input_parameter< bool >::type vectorized(vectorizedSEXP);
+    Rcpp::traits::input_parameter< bool >::type float32(float32SEXP);
+    Rcpp::traits::input_parameter< SEXP >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< bool >::type compact(compactSEXP);
+    Rcpp::traits::input_parameter< bool >::type fast(fastSEXP);
+    __result = Rcpp::wrap(rs_model(dayofyear, year, tz, latitude, longitude, interval, a, b, c, vectorized, float32, time, compact, fast));
+    return __result;
+END_RCPP
+}
+// ineichen_model
+SEXP ineichen_model(Rcpp::NumericVector dayofyear, Rcpp::NumericVector year, double tz, double latitude, double longitude, double interval, double elevation, double a, double b, double c, Rcpp::NumericVector TL, bool vectorized, bool float32, SEXP time, bool compact, bool fast);
+RcppExport SEXP clearskies_ineichen_model(SEXP dayofyearSEXP, SEXP yearSEXP, SEXP tzSEXP, SEXP latitudeSEXP, SEXP longitudeSEXP, SEXP intervalSEXP, SEXP elevationSEXP, SEXP aSEXP, SEXP bSEXP, SEXP cSEXP, SEXP TLSEXP, SEXP vectorizedSEXP, SEXP float32SEXP, SEXP timeSEXP, SEXP compactSEXP, SEXP fastSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type dayofyear(dayofyearSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type year(yearSEXP);
+    Rcpp::traits::input_parameter< double >::type tz(tzSEXP);
+    Rcpp::traits::input_parameter< double >::type latitude(latitudeSEXP);
+    Rcpp::traits::input_parameter< double >::type longitude(longitudeSEXP);
+    Rcpp::traits::input_parameter< double >::type interval(intervalSEXP);
+    Rcpp::traits::input_parameter< double >::type elevation(elevationSEXP);
+    Rcpp::traits::input_parameter< double >::type a(aSEXP);
+    Rcpp::traits::input_parameter< double >::type b(bSEXP);
+    Rcpp::traits::input_parameter< double >::type c(cSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type TL(TLSEXP);
+    Rcpp::traits::input_parameter< bool >::type vectorized(vectorizedSEXP);
+    Rcpp::traits::input_parameter< bool >::type float32(float32SEXP);
+    Rcpp::traits::input_parameter< SEXP >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< bool >::type compact(compactSEXP);
+    Rcpp::traits::input_parameter< bool >::type fast(fastSEXP);
+    __result = Rcpp::wrap(ineichen_model(dayofyear, year, tz, latitude, longitude, interval, elevation, a, b, c, TL, vectorized, float32, time, compact, fast));
+    return __result;
+END_RCPP
+}
+// model_ghi
+Rcpp::NumericVector model_ghi(Rcpp::NumericVector zenith, double io, std::string model, double a, double b, double c, double TL, double elevation, bool vectorized);
+RcppExport SEXP clearskies_model_ghi(SEXP zenithSEXP, SEXP ioSEXP, SEXP modelSEXP, SEXP aSEXP, SEXP bSEXP, SEXP cSEXP, SEXP TLSEXP, SEXP elevationSEXP, SEXP vectorizedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type zenith(zenithSEXP);
+    Rcpp::traits::input_parameter< double >::type io(ioSEXP);
+    Rcpp::traits::input_parameter< std::string >::type model(modelSEXP);
+    Rcpp::traits::input_parameter< double >::type a(aSEXP);
+    Rcpp::traits::input_parameter< double >::type b(bSEXP);
+    Rcpp::traits::input_parameter< double >::type c(cSEXP);
+    Rcpp::traits::input_parameter< double >::type TL(TLSEXP);
+    Rcpp::traits::input_parameter< double >::type elevation(elevationSEXP);
+    Rcpp::traits::input_parameter< bool >::type vectorized(vectorizedSEXP);
+    __result = Rcpp::wrap(model_ghi(zenith, io, model, a, b, c, TL, elevation, vectorized));
+    return __result;
+END_RCPP
+}
+// turbidity_grid
+Rcpp::XPtr<TurbidityGrid> turbidity_grid(std::string path, bool bilinear, bool monthly);
+RcppExport SEXP clearskies_turbidity_grid(SEXP pathSEXP, SEXP bilinearSEXP, SEXP monthlySEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< bool >::type bilinear(bilinearSEXP);
+    Rcpp::traits::input_parameter< bool >::type monthly(monthlySEXP);
+    __result = Rcpp::wrap(turbidity_grid(path, bilinear, monthly));
+    return __result;
+END_RCPP
+}
+// linke_turbidity
+Rcpp::NumericVector linke_turbidity(Rcpp::XPtr<TurbidityGrid> grid, double latitude, double longitude, Rcpp::NumericVector dayofyear);
+RcppExport SEXP clearskies_linke_turbidity(SEXP gridSEXP, SEXP latitudeSEXP, SEXP longitudeSEXP, SEXP dayofyearSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<TurbidityGrid> >::type grid(gridSEXP);
+    Rcpp::traits::input_parameter< double >::type latitude(latitudeSEXP);
+    Rcpp::traits::input_parameter< double >::type longitude(longitudeSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type dayofyear(dayofyearSEXP);
+    __result = Rcpp::wrap(linke_turbidity(grid, latitude, longitude, dayofyear));
+    return __result;
+END_RCPP
+}
+// write_turbidity_grid
+void write_turbidity_grid(Rcpp::NumericVector values, std::string path, double scale);
+RcppExport SEXP clearskies_write_turbidity_grid(SEXP valuesSEXP, SEXP pathSEXP, SEXP scaleSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type values(valuesSEXP);
+    Rcpp::traits::input_parameter< std::string >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< double >::type scale(scaleSEXP);
+    write_turbidity_grid(values, path, scale);
+    return R_NilValue;
+END_RCPP
+}
 // zenith
-Rcpp::NumericVector zenith(Rcpp::NumericVector dayofyear, Rcpp::NumericVector year, double tz, double latitude, double longitude, int interval);
-RcppExport SEXP clearskies_zenith(SEXP dayofyearSEXP, SEXP yearSEXP, SEXP tzSEXP, SEXP latitudeSEXP, SEXP longitudeSEXP, SEXP intervalSEXP) {
+SEXP zenith(Rcpp::NumericVector dayofyear, Rcpp::NumericVector year, double tz, double latitude, double longitude, double interval, bool vectorized, bool float32, bool profile, bool compact, bool fast);
+RcppExport SEXP clearskies_zenith(SEXP dayofyearSEXP, SEXP yearSEXP, SEXP tzSEXP, SEXP latitudeSEXP, SEXP longitudeSEXP, SEXP intervalSEXP, SEXP vectorizedSEXP, SEXP float32SEXP, SEXP profileSEXP, SEXP compactSEXP, SEXP fastSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type dayofyear(dayofyearSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type year(yearSEXP);
+    Rcpp::traits::input_parameter< double >::type tz(tzSEXP);
+    Rcpp::traits::input_parameter< double >::type latitude(latitudeSEXP);
+    Rcpp::traits::input_parameter< double >::type longitude(longitudeSEXP);
+    Rcpp::traits::input_parameter< double >::type interval(intervalSEXP);
+    Rcpp::traits::input_parameter< bool >::type vectorized(vectorizedSEXP);
+    Rcpp::traits::input_parameter< bool >::type float32(float32SEXP);
+    Rcpp::traits::input_parameter< bool >::type profile(profileSEXP);
+    Rcpp::traits::input_parameter< bool >::type compact(compactSEXP);
+    Rcpp::traits::input_parameter< bool >::type fast(fastSEXP);
+    __result = Rcpp::wrap(zenith(dayofyear, year, tz, latitude, longitude, interval, vectorized, float32, profile, compact, fast));
+    return __result;
+END_RCPP
+}
+// zenith_times
+SEXP zenith_times(Rcpp::NumericVector time, double tz, double latitude, double longitude, bool vectorized, bool float32, bool fast);
+RcppExport SEXP clearskies_zenith_times(SEXP timeSEXP, SEXP tzSEXP, SEXP latitudeSEXP, SEXP longitudeSEXP, SEXP vectorizedSEXP, SEXP float32SEXP, SEXP fastSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type time(timeSEXP);
+    Rcpp::traits::input_parameter< double >::type tz(tzSEXP);
+    Rcpp::traits::input_parameter< double >::type latitude(latitudeSEXP);
+    Rcpp::traits::input_parameter< double >::type longitude(longitudeSEXP);
+    Rcpp::traits::input_parameter< bool >::type vectorized(vectorizedSEXP);
+    Rcpp::traits::input_parameter< bool >::type float32(float32SEXP);
+    Rcpp::traits::input_parameter< bool >::type fast(fastSEXP);
+    __result = Rcpp::wrap(zenith_times(time, tz, latitude, longitude, vectorized, float32, fast));
+    return __result;
+END_RCPP
+}
+// ephemeris
+Rcpp::XPtr<EphemerisTable> ephemeris(Rcpp::NumericVector dayofyear, Rcpp::NumericVector year, double tz, double interval);
+RcppExport SEXP clearskies_ephemeris(SEXP dayofyearSEXP, SEXP yearSEXP, SEXP tzSEXP, SEXP intervalSEXP) {
 BEGIN_RCPP
     Rcpp::RObject __result;
     Rcpp::RNGScope __rngScope;
     Rcpp::traits::input_parameter< Rcpp::NumericVector >::type dayofyear(dayofyearSEXP);
     Rcpp::traits::input_parameter< Rcpp::NumericVector >::type year(yearSEXP);
     Rcpp::traits::input_parameter< double >::type tz(tzSEXP);
+    Rcpp::traits::input_parameter< double >::type interval(intervalSEXP);
+    __result = Rcpp::wrap(ephemeris(dayofyear, year, tz, interval));
+    return __result;
+END_RCPP
+}
+// zenith_ephemeris
+Rcpp::NumericVector zenith_ephemeris(Rcpp::XPtr<EphemerisTable> ephemeris, double latitude, double longitude);
+RcppExport SEXP clearskies_zenith_ephemeris(SEXP ephemerisSEXP, SEXP latitudeSEXP, SEXP longitudeSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< Rcpp::XPtr<EphemerisTable> >::type ephemeris(ephemerisSEXP);
     Rcpp::traits::input_parameter< double >::type latitude(latitudeSEXP);
     Rcpp::traits::input_parameter< double >::type longitude(longitudeSEXP);
-    Rcpp::traits::input_parameter< int >::type interval(intervalSEXP);
-    __result = Rcpp::wrap(zenith(dayofyear, year, tz, latitude, longitude, interval));
+    __result = Rcpp::wrap(zenith_ephemeris(ephemeris, latitude, longitude));
+    return __result;
+END_RCPP
+}
+// zenith_batch
+Rcpp::NumericMatrix zenith_batch(Rcpp::NumericVector dayofyear, Rcpp::NumericVector year, Rcpp::NumericVector tz, Rcpp::NumericVector latitude, Rcpp::NumericVector longitude, double interval, int threads);
+RcppExport SEXP clearskies_zenith_batch(SEXP dayofyearSEXP, SEXP yearSEXP, SEXP tzSEXP, SEXP latitudeSEXP, SEXP longitudeSEXP, SEXP intervalSEXP, SEXP threadsSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type dayofyear(dayofyearSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type year(yearSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type tz(tzSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type latitude(latitudeSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type longitude(longitudeSEXP);
+    Rcpp::traits::input_parameter< double >::type interval(intervalSEXP);
+    Rcpp::traits::input_parameter< int >::type threads(threadsSEXP);
+    __result = Rcpp::wrap(zenith_batch(dayofyear, year, tz, latitude, longitude, interval, threads));
+    return __result;
+END_RCPP
+}
+// time_cache_stats
+Rcpp::NumericMatrix time_cache_stats(bool clear);
+RcppExport SEXP clearskies_time_cache_stats(SEXP clearSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject __result;
+    Rcpp::RNGScope __rngScope;
+    Rcpp::traits::input_parameter< bool >::type clear(clearSEXP);
+    __result = Rcpp::wrap(time_cache_stats(clear));
     return __result;
 END_RCPP
 }
@@ -0,0 +1,221 @@
+#include <algorithm>   // copy, min, upper_bound
+#include <vector>
+#include <Rcpp.h>
+#include <Rversion.h>
+#include <R_ext/Rdynload.h>
+#include "altrep.h"
+#include "zenith.h"
+// [[Rcpp::plugins(cpp11)]]
+
+#if defined(R_VERSION) && R_VERSION >= R_Version(3, 6, 0)
+#define CLEARSKIES_ALTREP
+
+// Altrep.h names arguments class, which isn't valid C++
+#define class klass
+extern "C" {
+#include <R_ext/Altrep.h>
+}
+#undef class
+#endif
+
+// The runs of a compact series, and the values of the last run read, so that
+// reading a run an element at a time calculates it once.
+class CompactSeries {
+public:
+    CompactSeries(const std::vector<TimeRun> &runs, const double *utime,
+                  long n_utime, long n, RunFill fill)
+        : runs_(runs), n_(n), fill_(fill), cached_(-1) {
+        if (utime != NULL) utime_.assign(utime, utime + n_utime);
+        for (TimeRun &run : runs_) {
+            if (run.utime != NULL) run.utime = utime_.data() + (run.utime - utime);
+        }
+    }
+
+    long size() const { return n_; }
+
+    // Value of point i.
+    double value(long i) {
+        size_t r = find(i);
+        return run_values(r)[i - runs_[r].first];
+    }
+
+    // Write the size values starting from point first to out. Runs wholly
+    // within the range are written in place.
+    void values(long first, long size, double *out) {
+        for (size_t r = find(first); r < runs_.size() && size > 0; ++r) {
+            const TimeRun &run = runs_[r];
+            long offset = first - run.first;
+            long len = std::min(run.n - offset, size);
+            if (len == run.n) {
+                fill_(run, out);
+            } else {
+                const double *v = run_values(r);
+                std::copy(v + offset, v + offset + len, out);
+            }
+            first += len;
+            out += len;
+            size -= len;
+        }
+    }
+
+private:
+    std::vector<TimeRun> runs_;
+    std::vector<double> utime_;
+    long n_;
+    RunFill fill_;
+    std::vector<double> cache_;
+    long cached_;       // run whose values are in cache_, or -1
+
+    // Index of the run containing point i.
+    size_t find(long i) const {
+        auto after = std::upper_bound(
+            runs_.begin(), runs_.end(), i,
+            [](long i, const TimeRun &run) { return i < run.first; });
+        return after - runs_.begin() - 1;
+    }
+
+    const double *run_values(size_t r) {
+        if (cached_ != (long) r) {
+            cache_.resize(runs_[r].n);
+            fill_(runs_[r], cache_.data());
+            cached_ = r;
+        }
+        return cache_.data();
+    }
+};
+
+#ifdef CLEARSKIES_ALTREP
+
+// data1 of a compact vector is an external pointer to its CompactSeries, and
+// data2 is R_NilValue until the vector is materialized into a numeric vector.
+// The series is then released, and the vector reads its materialized values.
+static R_altrep_class_t compact_class;
+
+static CompactSeries *compact_of(SEXP x) {
+    return static_cast<CompactSeries *>(R_ExternalPtrAddr(R_altrep_data1(x)));
+}
+
+static SEXP materialize(SEXP x) {
+    SEXP values = R_altrep_data2(x);
+    if (values != R_NilValue) return values;
+
+    CompactSeries *series = compact_of(x);
+    values = PROTECT(Rf_allocVector(REALSXP, series->size()));
+    series->values(0, series->size(), REAL(values));
+    R_set_altrep_data2(x, values);
+    R_set_altrep_data1(x, R_NilValue);
+    UNPROTECT(1);
+    return values;
+}
+
+static R_xlen_t compact_length(SEXP x) {
+    SEXP values = R_altrep_data2(x);
+    return values == R_NilValue ? compact_of(x)->size() : XLENGTH(values);
+}
+
+static Rboolean compact_inspect(SEXP x, int, int, int,
+                                void (*)(SEXP, int, int, int)) {
+    Rprintf(" clearskies compact series (%s)\n",
+            R_altrep_data2(x) == R_NilValue ? "compact" : "materialized");
+    return TRUE;
+}
+
+static void *compact_dataptr(SEXP x, Rboolean) {
+    return REAL(materialize(x));
+}
+
+static const void *compact_dataptr_or_null(SEXP x) {
+    SEXP values = R_altrep_data2(x);
+    return values == R_NilValue ? NULL : REAL(values);
+}
+
+static double compact_elt(SEXP x, R_xlen_t i) {
+    SEXP values = R_altrep_data2(x);
+    return values == R_NilValue ? compact_of(x)->value(i) : REAL(values)[i];
+}
+
+static R_xlen_t compact_get_region(SEXP x, R_xlen_t start, R_xlen_t size,
+                                   double *buf) {
+    R_xlen_t n = compact_length(x);
+    if (start >= n) return 0;
+    size = std::min(size, n - start);
+
+    SEXP values = R_altrep_data2(x);
+    if (values == R_NilValue) {
+        compact_of(x)->values(start, size, buf);
+    } else {
+        std::copy(REAL(values) + start, REAL(values) + start + size, buf);
+    }
+    return size;
+}
+
+#endif
+
+//' Check whether compact series are supported.
+//'
+//' @return TRUE if compact series are calculated when read, which needs R
+//' 3.6.0 or later, or FALSE if they are calculated at once.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+bool compact_supported() {
+#ifdef CLEARSKIES_ALTREP
+    return true;
+#else
+    return false;
+#endif
+}
+
+SEXP compact_series(const std::vector<TimeRun> &runs, const double *utime,
+                    long n_utime, long n, RunFill fill) {
+#ifdef CLEARSKIES_ALTREP
+    Rcpp::XPtr<CompactSeries> series(new CompactSeries(runs, utime, n_utime, n, fill));
+    return R_new_altrep(compact_class, series, R_NilValue);
+#else
+    // the runs are only filled now, so their times needn't be copied
+    (void) utime;
+    (void) n_utime;
+    Rcpp::NumericVector values(n);
+    for (const TimeRun &run : runs) {
+        fill(run, values.begin() + run.first);
+    }
+    return values;
+#endif
+}
+
+//' Check whether a vector is a compact series.
+//'
+//' @param x Any R object.
+//'
+//' @return TRUE if x is a compact series, as returned with compact = TRUE by
+//' \code{\link{zenith}}, \code{\link{exrad}} and the models, whose values
+//' haven't all been calculated yet. Always FALSE before R 3.6.0, where
+//' compact series are calculated at once.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+bool is_compact(SEXP x) {
+#ifdef CLEARSKIES_ALTREP
+    return ALTREP(x) && R_altrep_inherits(x, compact_class) &&
+        R_altrep_data2(x) == R_NilValue;
+#else
+    (void) x;
+    return false;
+#endif
+}
+
+// Registers the compact series class. Routines are still found dynamically,
+// as registered by useDynLib.
+extern "C" void R_init_clearskies(DllInfo *dll) {
+#ifdef CLEARSKIES_ALTREP
+    compact_class = R_make_altreal_class("compact_series", "clearskies", dll);
+    R_set_altrep_Length_method(compact_class, compact_length);
+    R_set_altrep_Inspect_method(compact_class, compact_inspect);
+    R_set_altvec_Dataptr_method(compact_class, compact_dataptr);
+    R_set_altvec_Dataptr_or_null_method(compact_class, compact_dataptr_or_null);
+    R_set_altreal_Elt_method(compact_class, compact_elt);
+    R_set_altreal_Get_region_method(compact_class, compact_get_region);
+#else
+    (void) dll;
+#endif
+}
@@ -0,0 +1,32 @@
+#ifndef CLEARSKIES_ALTREP_H
+#define CLEARSKIES_ALTREP_H
+
+#include <functional>
+#include <vector>
+#include <Rcpp.h>
+#include "zenith.h"
+
+// Compact series: numeric vectors whose values are calculated when read, a
+// run of the series at a time, defined in altrep.cpp. They are ALTREP vectors
+// where R supports them, so that a series costs only its runs until read,
+// and reading a few days of it only calculates those days. Reading the
+// whole series through a pointer, as most native code does, calculates it
+// once and keeps the values.
+
+// Writes the values of run to its second argument, which has room for run.n
+// values. Called whenever a run is read, so it must always give the same
+// values, and may be called after the export creating the series returns.
+typedef std::function<void(const TimeRun &, double *)> RunFill;
+
+// Whether compact_series returns compact vectors, which needs R 3.6.0 or
+// later. Otherwise it calculates the whole series at once.
+bool compact_supported();
+
+// Series of n values, the values of each of runs written by fill. The runs
+// must be in order and cover every point. Their universal times point into
+// the n_utime times at utime, which are copied, or may be null if fill
+// doesn't use them.
+SEXP compact_series(const std::vector<TimeRun> &runs, const double *utime,
+                    long n_utime, long n, RunFill fill);
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef CLEARSKIES_BITS_H
+#define CLEARSKIES_BITS_H
+
+#include <stdint.h>    // uint64_t
+
+// Flags packed 8 to a byte, independent of the R API. The flag of point i is
+// bit i % 8, counting from the least significant, of byte i / 8, and the
+// unused bits of the last byte are 0.
+
+// Bytes holding n flags.
+inline long bit_bytes(long n) {
+    return (n + 7) / 8;
+}
+
+inline bool get_bit(const unsigned char *bits, long i) {
+    return (bits[i >> 3] >> (i & 7)) & 1;
+}
+
+inline void set_bit(unsigned char *bits, long i) {
+    bits[i >> 3] |= (unsigned char) (1u << (i & 7));
+}
+
+// The 64 flags of the 8 bytes at bits, as the bits of a word from the least
+// significant, whatever the byte order. Compilers turn this into one load.
+inline uint64_t load_bits64(const unsigned char *bits) {
+    uint64_t word = 0;
+    for (int k = 0; k < 8; ++k) {
+        word |= (uint64_t) bits[k] << (8 * k);
+    }
+    return word;
+}
+
+inline int popcount64(uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (int) ((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Index of the lowest set bit of x, which must not be 0.
+inline int lowest_bit64(uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    int k = 0;
+    while (!((x >> k) & 1)) ++k;
+    return k;
+#endif
+}
+
+// Number of flags set from first to last - 1, a word at a time.
+inline long count_bits(const unsigned char *bits, long first, long last) {
+    long count = 0;
+    for (; first < last && (first & 63); ++first) {
+        count += get_bit(bits, first);
+    }
+    for (; first + 64 <= last; first += 64) {
+        count += popcount64(load_bits64(bits + (first >> 3)));
+    }
+    for (; first < last; ++first) {
+        count += get_bit(bits, first);
+    }
+    return count;
+}
+
+// Index of the first flag from first to n - 1 equal to value, or n if there
+// is none. Whole words of the other value are skipped at once.
+inline long find_bit(const unsigned char *bits, long first, long n, bool value) {
+    for (; first < n && (first & 63); ++first) {
+        if (get_bit(bits, first) == value) return first;
+    }
+    for (; first + 64 <= n; first += 64) {
+        uint64_t word = load_bits64(bits + (first >> 3));
+        if (!value) word = ~word;
+        if (word) return first + lowest_bit64(word);
+    }
+    for (; first < n; ++first) {
+        if (get_bit(bits, first) == value) return first;
+    }
+    return n;
+}
+
+#endif
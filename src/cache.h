@@ -0,0 +1,90 @@
+#ifndef CLEARSKIES_CACHE_H
+#define CLEARSKIES_CACHE_H
+
+#include <list>
+#include <map>
+#include <memory>      // shared_ptr
+#include <mutex>
+#include <string.h>    // memcpy
+#include <stdint.h>    // uint64_t
+#include <utility>     // pair
+#include <vector>
+
+// Cache of at most capacity values, evicting the least recently used, and
+// safe to use from any thread. Independent of the R API.
+//
+// Values are shared, so a value stays valid for as long as it is held, even
+// once evicted. Values are calculated outside the lock, so two threads
+// missing the same key may both calculate it; the first to finish is kept.
+template <typename Key, typename Value>
+class LruCache {
+public:
+    typedef std::shared_ptr<const Value> Shared;
+
+    explicit LruCache(size_t capacity)
+        : capacity_(capacity), hits_(0), misses_(0) {}
+
+    // The value of key, calculating it with compute() if not cached.
+    template <typename Compute>
+    Shared get(const Key &key, Compute compute) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            typename Index::iterator it = index_.find(key);
+            if (it != index_.end()) {
+                ++hits_;
+                entries_.splice(entries_.begin(), entries_, it->second);
+                return it->second->second;
+            }
+            ++misses_;
+        }
+
+        Shared value = std::make_shared<const Value>(compute());
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        typename Index::iterator it = index_.find(key);
+        if (it != index_.end()) return it->second->second;
+        if (capacity_ == 0) return value;
+
+        if (entries_.size() >= capacity_) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+        entries_.push_front(std::make_pair(key, value));
+        index_[key] = entries_.begin();
+        return value;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+        index_.clear();
+    }
+
+    // Counts of lookups found and not found in the cache, and its size.
+    void stats(double *hits, double *misses, double *size) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        *hits = hits_;
+        *misses = misses_;
+        *size = entries_.size();
+    }
+
+private:
+    typedef std::list< std::pair<Key, Shared> > Entries;
+    typedef std::map<Key, typename Entries::iterator> Index;
+
+    size_t capacity_;
+    Entries entries_;       // most recently used first
+    Index index_;
+    double hits_, misses_;
+    std::mutex mutex_;
+};
+
+// Bit pattern of x, so that doubles are compared exactly, and NaN are keys
+// like any other value.
+inline uint64_t double_bits(double x) {
+    uint64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return bits;
+}
+
+#endif
@@ -0,0 +1,151 @@
+#include <algorithm>   // min
+#include <stdexcept>   // range_error
+#include <vector>
+#include <Rcpp.h>
+#include "bits.h"
+#include "clearmask.h"
+
+Rcpp::RawVector new_clear_mask(long n) {
+    Rcpp::RawVector mask(bit_bytes(n));
+    mask.attr("n") = (double) n;
+    mask.attr("class") = "clearmask";
+    return mask;
+}
+
+const unsigned char *clear_mask_bits(SEXP mask, long *n) {
+    if (TYPEOF(mask) != RAWSXP || !Rf_inherits(mask, "clearmask"))
+        throw std::range_error("x must be a clearmask");
+    SEXP points = Rf_getAttrib(mask, Rf_install("n"));
+    if (Rf_length(points) != 1 || Rf_asReal(points) < 0 ||
+        bit_bytes((long) Rf_asReal(points)) != Rf_length(mask))
+        throw std::range_error("x must be a clearmask");
+
+    *n = (long) Rf_asReal(points);
+    return RAW(mask);
+}
+
+//' Pack clear points into a clear mask.
+//'
+//' Clear masks hold 1 bit for each point, a 32nd of the memory of a logical
+//' vector. \code{sum}, \code{mean} and \code{length} count the points without
+//' unpacking them, \code{\link{mask_runs}} and \code{\link{mask_days}} give
+//' the clear runs and the clear points of each day, and \code{as.logical}
+//' unpacks them. \code{\link{clear_points}} returns a clear mask with
+//' packed = TRUE.
+//'
+//' @param x Logical vector, TRUE for clear points. Must not be NA.
+//'
+//' @return A raw vector of class 'clearmask', with attribute n, the number of
+//' points.
+//'
+//' @export
+// [[Rcpp::export]]
+Rcpp::RawVector as_clearmask(Rcpp::LogicalVector x) {
+    long n = x.size();
+    Rcpp::RawVector mask = new_clear_mask(n);
+    unsigned char *bits = mask.begin();
+    for (long i = 0; i < n; ++i) {
+        if (x[i] == NA_LOGICAL)
+            throw std::range_error("x must not be NA");
+        if (x[i]) set_bit(bits, i);
+    }
+    return mask;
+}
+
+//' Unpack a clear mask.
+//'
+//' @param x Clear mask, see \code{\link{as_clearmask}}.
+//' @param index Optional indices of the points to unpack, from 1. NA or out of
+//' range indices give NA.
+//'
+//' @return A logical vector of the points of x, or of those at index.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::LogicalVector mask_logical(SEXP x, SEXP index = R_NilValue) {
+    long n;
+    const unsigned char *bits = clear_mask_bits(x, &n);
+
+    if (Rf_isNull(index)) {
+        Rcpp::LogicalVector flags(n);
+        for (long i = 0; i < n; ++i) {
+            flags[i] = get_bit(bits, i);
+        }
+        return flags;
+    }
+
+    Rcpp::NumericVector at(index);
+    Rcpp::LogicalVector flags(at.size());
+    for (long k = 0; k < at.size(); ++k) {
+        double i = at[k] - 1;
+        flags[k] = (i >= 0 && i < n) ? get_bit(bits, (long) i) : NA_LOGICAL;
+    }
+    return flags;
+}
+
+//' Count the clear points of a clear mask.
+//'
+//' @param x Clear mask, see \code{\link{as_clearmask}}.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+double mask_count(SEXP x) {
+    long n;
+    const unsigned char *bits = clear_mask_bits(x, &n);
+    return count_bits(bits, 0, n);
+}
+
+//' Runs of clear points of a clear mask.
+//'
+//' Whole words of 64 points are skipped at once, so the runs of a mostly
+//' cloudy, or mostly clear, series are found in a fraction of a pass over its
+//' points.
+//'
+//' @param x Clear mask, see \code{\link{as_clearmask}}.
+//'
+//' @return A data frame with columns start and end, the first and last index
+//' of each run of clear points, inclusive, as \code{\link{clear_segments}}.
+//'
+//' @export
+// [[Rcpp::export]]
+Rcpp::DataFrame mask_runs(SEXP x) {
+    long n;
+    const unsigned char *bits = clear_mask_bits(x, &n);
+
+    std::vector<double> start, end;
+    long k = find_bit(bits, 0, n, true);
+    while (k < n) {
+        long last = find_bit(bits, k, n, false);
+        start.push_back(k + 1);
+        end.push_back(last);
+        k = find_bit(bits, last, n, true);
+    }
+
+    return Rcpp::DataFrame::create(Rcpp::Named("start") = Rcpp::wrap(start),
+                                   Rcpp::Named("end") = Rcpp::wrap(end));
+}
+
+//' Clear points of each day of a clear mask.
+//'
+//' @param x Clear mask, see \code{\link{as_clearmask}}.
+//' @param day_length Number of points in a day, e.g. 1440 for every minute.
+//' The last day may have fewer points.
+//'
+//' @return A numeric vector of the number of clear points of each day.
+//'
+//' @export
+// [[Rcpp::export]]
+Rcpp::NumericVector mask_days(SEXP x, double day_length) {
+    long n;
+    const unsigned char *bits = clear_mask_bits(x, &n);
+    if (!(day_length >= 1) || day_length != (long) day_length)
+        throw std::range_error("day_length must be a positive integer");
+
+    long len = (long) day_length;
+    long n_days = (n + len - 1) / len;
+    Rcpp::NumericVector counts(n_days);
+    for (long d = 0; d < n_days; ++d) {
+        counts[d] = count_bits(bits, d * len, std::min((d + 1) * len, n));
+    }
+    return counts;
+}
@@ -0,0 +1,17 @@
+#ifndef CLEARSKIES_CLEARMASK_H
+#define CLEARSKIES_CLEARMASK_H
+
+#include <Rcpp.h>
+
+// Clear points packed as in bits.h, 1 bit each, in a raw vector of class
+// 'clearmask'. Attribute n is the number of points, as the bytes only give
+// it to a multiple of 8.
+
+// A clear mask of n points, none clear.
+Rcpp::RawVector new_clear_mask(long n);
+
+// The bits of mask, with its number of points in n. Throws std::range_error if
+// mask isn't a clear mask.
+const unsigned char *clear_mask_bits(SEXP mask, long *n);
+
+#endif
@@ -1,6 +1,18 @@
-#include <algorithm>   // replace
+#include <algorithm>   // min, max
+#include <atomic>
+#include <cmath>       // floor
 #include <stdexcept>   // range_error
+#include <vector>
 #include <Rcpp.h>
+#include "bits.h"
+#include "clearmask.h"
+#include "columns.h"
+#include "criterion.h"
+#include "detect.h"
+#include "float32.h"
+#include "parallel.h"
+#include "profile.h"
+#include "rescale.h"
 
 //' Calculate line length variability.
 //'
@@ -23,8 +35,7 @@
 //' @keywords internal
 //
 double L(Rcpp::NumericVector &x) {
-    // (t_(i+1) - t_(i))^2 is always 1
-    return sum(sqrt(pow(diff(x), 2) + 1));
+    return line_length(x.begin(), x.size());
 }
 
 //' Normalized standard deviation of the slope between sequential points.
@@ -50,15 +61,7 @@ double L(Rcpp::NumericVector &x) {
 //' @keywords internal
 //
 double sigma(Rcpp::NumericVector &x) {
-    Rcpp::NumericVector s = diff(x);
-    double sigma = sd(s) / mean(x);
-
-    // catch division by 0
-    if (std::isnan(sigma) || std::isinf(sigma)) {
-        return 0.0;
-    }
-
-    return sigma;
+    return slope_sigma(x.begin(), x.size());
 }
 
 //' Maximum deviation of the measured irradiance from the clear sky slope.
@@ -85,7 +88,7 @@ double sigma(Rcpp::NumericVector &x) {
 //' @keywords internal
 //
 double S(Rcpp::NumericVector &x, Rcpp::NumericVector &cs) {
-    return max(abs(diff(x) - diff(cs)));
+    return max_deviation(x.begin(), cs.begin(), x.size());
 }
 
 //' Calculate five clear sky criterion.
@@ -99,15 +102,34 @@ double S(Rcpp::NumericVector &x, Rcpp::NumericVector &cs) {
 //' @keywords internal
 //
 Rcpp::NumericVector calculate_criterion(Rcpp::NumericVector &x, Rcpp::NumericVector &cs) {
-    Rcpp::NumericVector criterion(5);
-    criterion[0] = mean(x) - mean(cs);    // mean difference
-    criterion[1] = max(x) - max(cs);      // max difference
-    criterion[2] = L(x) - L(cs);          // line length difference
-    criterion[3] = sigma(x) - sigma(cs);  // sigma difference
-    criterion[4] = S(x, cs);              // max deviance
+    Rcpp::NumericVector criterion(N_CRITERION);
+    window_criterion(x.begin(), cs.begin(), x.size(), criterion.begin());
     return criterion;
 }
 
+// Validate thresholds and extract the minimum and maximum of each vector, so
+// that detection doesn't need the R API.
+Thresholds to_thresholds(Rcpp::List &thresholds) {
+    if (thresholds.size() != 5)
+        throw std::range_error("Thresholds must be a list of length 5");
+
+    double lower[N_CRITERION], upper[N_CRITERION];
+    for (int i = 0; i < N_CRITERION; ++i) {
+        SEXP element = thresholds[i];
+        if (!Rf_isNumeric(element) || Rf_length(element) < 2)
+            throw std::range_error("Each threshold must be a numeric vector of length two or more");
+
+        Rcpp::NumericVector b(element);
+        if (std::any_of(b.begin(), b.end(), [](double v) { return ISNAN(v); }))
+            throw std::range_error("Thresholds must not be NA");
+
+        lower[i] = min(b);
+        upper[i] = max(b);
+    }
+
+    return Thresholds(lower, upper);
+}
+
 //' Check if all criterion are within their respective threshold values.
 //'
 //' @param criterion List of clear sky criterion.
@@ -130,19 +152,195 @@ bool evaluate_criterion(Rcpp::NumericVector &criterion, Rcpp::List &thresholds)
     // to return True (clear).
     // thresholds must be checked and ordered in R
     // i.e. must be length 5
-    auto j = thresholds.begin();
-    for (auto i = criterion.begin(); i != criterion.end(); ++i, ++j) {
-        // comparison may not work correctly if dereferenced iterators are
-        // compared directly
-        Rcpp::NumericVector bounds = *j;
-        double criteria = *i;
-
-        if (criteria < min(bounds) || criteria > max(bounds)) {
-            return false;
+    Thresholds bounds = to_thresholds(thresholds);
+    return within_thresholds(criterion.begin(), bounds);
+}
+
+// Measured or predicted irradiance, either a numeric vector or float32.
+class Series {
+public:
+    explicit Series(SEXP x) : float32_(Rf_inherits(x, "float32")) {
+        if (float32_) {
+            packed_ = x;
+            if (packed_.size() % FLOAT32_SIZE != 0)
+                throw std::range_error("float32 values must have a multiple of 4 bytes");
+        } else {
+            values_ = x;
         }
     }
 
-    return true;
+    bool is_float32() const { return float32_; }
+
+    int size() const {
+        return float32_ ? packed_.size() / FLOAT32_SIZE : values_.size();
+    }
+
+    const float *floats() const { return float32_values(packed_.begin()); }
+
+    // Bytes allocated converting float32 values to doubles.
+    double converted_bytes() const {
+        return float32_ ? (double) values_.size() * sizeof(double) : 0;
+    }
+
+    // The values as doubles, converting float32 values on first use.
+    const double *doubles() {
+        if (float32_ && values_.size() != size()) {
+            values_ = Rcpp::NumericVector(size());
+            unpack_float32(packed_.begin(), size(), values_.begin());
+        }
+        return values_.begin();
+    }
+
+private:
+    bool float32_;
+    Rcpp::RawVector packed_;
+    Rcpp::NumericVector values_;
+};
+
+// Names of the criterion, as in the thresholds dataset.
+Rcpp::CharacterVector criterion_names() {
+    return Rcpp::CharacterVector::create("Mean", "Max", "Line.length", "Sigma",
+                                         "Deviation");
+}
+
+// Timings and counters of a clear_pts call, see its profile argument.
+struct DetectProfile {
+    StageTimes times;
+    DetectStats stats;
+    long interrupt_checks;
+    double interrupt_seconds;
+    double bytes;       // allocated for buffers and the result
+
+    DetectProfile() : interrupt_checks(0), interrupt_seconds(0), bytes(0) {}
+
+    Rcpp::List result() const {
+        Rcpp::NumericVector windows = Rcpp::NumericVector::create(
+            Rcpp::Named("evaluated") = (double) stats.evaluated,
+            Rcpp::Named("dark") = (double) stats.dark,
+            Rcpp::Named("gaps") = (double) stats.gaps);
+        Rcpp::NumericVector rejected(stats.rejected, stats.rejected + N_CRITERION);
+        rejected.attr("names") = criterion_names();
+        Rcpp::NumericVector interrupts = Rcpp::NumericVector::create(
+            Rcpp::Named("checks") = (double) interrupt_checks,
+            Rcpp::Named("seconds") = interrupt_seconds);
+
+        return Rcpp::List::create(Rcpp::Named("seconds") = times.result(),
+                                  Rcpp::Named("windows") = windows,
+                                  Rcpp::Named("rejected") = rejected,
+                                  Rcpp::Named("interrupts") = interrupts,
+                                  Rcpp::Named("bytes") = bytes);
+    }
+};
+
+// Call set_clear(k) for each point k of x and cs covered by a clear window,
+// in order; see clear_pts. If profile is given, the detection and merge
+// stages are timed and the windows counted in it.
+template <typename Sample, typename SetClear>
+void detect_flags(const Sample *px, const Sample *pcs, long n, int window_len,
+                  const Thresholds &bounds, int threads, const double *pz,
+                  double max_zenith, SetClear set_clear, DetectProfile *profile = 0) {
+    long n_windows = n - window_len + 1;
+
+    // windows are split into one contiguous range per thread. Each range
+    // flags its own copy of the points it covers, which overlap with the
+    // next range by window_len - 1 points.
+    // ranges start at multiples of window_len, where a serial pass recomputes
+    // its running sums from the window, so the criterion are exactly the same
+    long chunk_len = (n_windows + threads - 1) / threads;
+    chunk_len = (chunk_len + window_len - 1) / window_len * window_len;
+    int n_chunks = (n_windows + chunk_len - 1) / chunk_len;
+    std::vector< std::vector<unsigned char> > marks(n_chunks);
+
+    if (n_chunks == 1) {
+        marks[0].assign(n, 0);
+        detect_clear(px, pcs, 0, n_windows, window_len, bounds,
+                     marks[0].data(), [profile]() {
+                         if (!profile) {
+                             Rcpp::checkUserInterrupt();
+                             return false;
+                         }
+                         StageTimes::Clock::time_point start = StageTimes::Clock::now();
+                         Rcpp::checkUserInterrupt();
+                         ++profile->interrupt_checks;
+                         profile->interrupt_seconds +=
+                             StageTimes::seconds(start, StageTimes::Clock::now());
+                         return false;
+                     }, pz, max_zenith, profile ? &profile->stats : 0);
+    } else {
+        for (int t = 0; t < n_chunks; ++t) {
+            long first = t * chunk_len;
+            long last = std::min(first + chunk_len, n_windows);
+            marks[t].assign(last - first + window_len - 1, 0);
+        }
+
+        // each thread counts its own windows
+        std::vector<DetectStats> stats(profile ? n_chunks : 0);
+        run_parallel(n_chunks, [&](int t, const std::atomic<bool> &cancel) {
+            long first = t * chunk_len;
+            long last = std::min(first + chunk_len, n_windows);
+            detect_clear(px, pcs, first, last, window_len, bounds,
+                         marks[t].data(), [&cancel]() { return cancel.load(); },
+                         pz, max_zenith, profile ? &stats[t] : 0);
+        });
+        for (size_t t = 0; t < stats.size(); ++t) {
+            profile->stats.add(stats[t]);
+        }
+    }
+    if (profile) profile->times.end("detect");
+
+    // a point is clear if any window covering it is clear. Chunks overlap
+    // by window_len - 1 points, which are only set once
+    long next = 0;
+    for (int t = 0; t < n_chunks; ++t) {
+        long first = t * chunk_len;
+        for (long k = std::max(first, next); k < first + (long) marks[t].size(); ++k) {
+            bool clear = marks[t][k - first] ||
+                (t + 1 < n_chunks && k >= first + chunk_len &&
+                 marks[t + 1][k - first - chunk_len]);
+            if (clear) set_clear(k);
+        }
+        next = first + marks[t].size();
+    }
+
+    if (profile) {
+        profile->times.end("merge");
+        for (int t = 0; t < n_chunks; ++t) {
+            profile->bytes += marks[t].size();
+        }
+    }
+}
+
+// The points of x and cs covered by a clear window, as a logical vector; see
+// detect_flags.
+template <typename Sample>
+Rcpp::LogicalVector detect_points(const Sample *px, const Sample *pcs, int n,
+                                  int window_len, const Thresholds &bounds,
+                                  int threads, const double *pz, double max_zenith,
+                                  DetectProfile *profile = 0) {
+    Rcpp::LogicalVector clear(n);
+    detect_flags(px, pcs, n, window_len, bounds, threads, pz, max_zenith,
+                 [&clear](long k) { clear[k] = true; }, profile);
+    if (profile) profile->bytes += (double) n * sizeof(int);
+    return clear;
+}
+
+// The points of x and cs covered by a clear window, as a clear mask if packed,
+// otherwise a logical vector; see detect_flags.
+template <typename Sample>
+SEXP detect_result(const Sample *px, const Sample *pcs, int n, int window_len,
+                   const Thresholds &bounds, int threads, const double *pz,
+                   double max_zenith, bool packed, DetectProfile *profile = 0) {
+    if (!packed) {
+        return detect_points(px, pcs, n, window_len, bounds, threads, pz,
+                             max_zenith, profile);
+    }
+
+    Rcpp::RawVector clear = new_clear_mask(n);
+    unsigned char *bits = clear.begin();
+    detect_flags(px, pcs, n, window_len, bounds, threads, pz, max_zenith,
+                 [bits](long k) { set_bit(bits, k); }, profile);
+    if (profile) profile->bytes += clear.size();
+    return clear;
 }
 
 //' Clear sky detection
@@ -150,6 +348,8 @@ bool evaluate_criterion(Rcpp::NumericVector &criterion, Rcpp::List &thresholds)
 //' Determine clear points using a rolling window and five clear sky criterion.
 //'
 //' A point is declared clear if it is determined to be clear at least once.
+//' NA values in x or cs are gaps, and a window containing a gap is never
+//' clear.
 //'
 //' @param x Numeric vector of measured irradiance values.
 //' @param cs Numeric vector of predicted irradiance from a clear sky model.
@@ -167,52 +367,578 @@ bool evaluate_criterion(Rcpp::NumericVector &criterion, Rcpp::List &thresholds)
 //' }
 //' @param window_len Length of window, in minutes, used in calculating
 //' criterion. Must be a positive integer.
+//' @param threads Number of threads to run detection on. The windows are split
+//' into one contiguous range per thread.
+//' @param zenith Optional numeric vector of the solar zenith angle, in
+//' degrees, at each point of x. Windows where the sun is below min_elevation
+//' at every point are never clear, and are skipped without calculating their
+//' criterion.
+//' @param min_elevation Sun elevation, in degrees, below which a point is
+//' dark. Only used with zenith.
+//' @param profile If TRUE, time the stages of detection and count the
+//' windows, returned in attribute 'profile' of the result.
+//' @param packed If TRUE, return the clear points as a clear mask, 1 bit for
+//' each point, see \code{\link{as_clearmask}}.
 //'
 //' @return A logical vector of the same length as x, TRUE indicates the
 //' point is clear.
 //' @return A logical vector of the same length as x. TRUE indicates that the
-//' corresponding measured irradiance value in x is clear.
+//' corresponding measured irradiance value in x is clear. If packed is TRUE,
+//' a clear mask of the same points.
+//'
+//' If profile is TRUE, attribute 'profile' is a list of
+//' \describe{
+//'     \item{seconds}{wall clock seconds of each stage: setup, checking and
+//'     converting the arguments; detect, evaluating the windows; and merge,
+//'     building the result.}
+//'     \item{windows}{the number of windows evaluated, and of those skipped
+//'     as dark or as containing an NA.}
+//'     \item{rejected}{the number of evaluated windows failing each
+//'     criterion. Criterion are tested one at a time, the most selective
+//'     on the data so far first, and only the first failed is counted.}
+//'     \item{interrupts}{the number of checks for user interrupts, and the
+//'     seconds spent in them, during single threaded detection.}
+//'     \item{bytes}{bytes allocated for converted series, working buffers and
+//'     the result.}
+//' }
 //'
 //' @section References:
 //' Global Horizontal Irradiance Clear Sky Models: Implementation and Analysis,
 //' Reno et al, 2012, pp. 28-36.
 //'
 // [[Rcpp::export]]
-Rcpp::LogicalVector clear_pts(Rcpp::NumericVector x, Rcpp::NumericVector cs,
-                              Rcpp::List thresholds, int window_len) {
-    int n = x.size();
+SEXP clear_pts(SEXP x, SEXP cs, Rcpp::List thresholds, int window_len,
+               int threads = 1, SEXP zenith = R_NilValue, double min_elevation = 0,
+               bool profile = false, bool packed = false) {
+    DetectProfile timings;
+    DetectProfile *prof = profile ? &timings : 0;
+
+    Series obs(x), pred(cs);
+    int n = obs.size();
 
-    if (n != cs.size())
+    if (n != pred.size())
         throw std::range_error("x must be the same length as cs");
     if (window_len <= 0 || window_len > n)
         throw std::range_error("Incorrect value to window_len");
-    if (thresholds.size() != 5)
-        throw std::range_error("Thresholds must be a list of length 5");
+    if (threads <= 0)
+        throw std::range_error("threads must be a positive integer");
 
-    Rcpp::LogicalVector clear(n);
-    Rcpp::NumericVector obs(window_len);
-    Rcpp::NumericVector pred(window_len);
+    Thresholds bounds = to_thresholds(thresholds);
 
-    auto j = cs.begin();
-    auto k = clear.begin();
+    const double *pz = 0;
+    Rcpp::NumericVector angles;
+    if (!Rf_isNull(zenith)) {
+        angles = zenith;
+        if (angles.size() != n)
+            throw std::range_error("zenith must be the same length as x");
+        pz = angles.begin();
+    }
+    double max_zenith = 90 - min_elevation;
+
+    // float32 samples are only read in place if both series are float32,
+    // otherwise the float32 one is converted
+    Rcpp::RObject clear;
+    if (obs.is_float32() && pred.is_float32()) {
+        if (prof) prof->times.end("setup");
+        clear = detect_result(obs.floats(), pred.floats(), n, window_len, bounds,
+                              threads, pz, max_zenith, packed, prof);
+    } else {
+        const double *px = obs.doubles(), *pcs = pred.doubles();
+        if (prof) {
+            prof->times.end("setup");
+            prof->bytes += obs.converted_bytes() + pred.converted_bytes();
+        }
+        clear = detect_result(px, pcs, n, window_len, bounds, threads, pz,
+                              max_zenith, packed, prof);
+    }
 
-    for (auto i = x.begin(); i != x.end() - window_len + 1; ++i, ++j, ++k) {
-        obs.assign(i, i + window_len);
-        pred.assign(j, j + window_len);
+    if (prof) clear.attr("profile") = prof->result();
+    return clear;
+}
 
-        auto criterion = calculate_criterion(obs, pred);
-        bool allclear = evaluate_criterion(criterion, thresholds);
+// The values of a float64 or float32 column of a column file, converted to
+// doubles in convert if float32 and convert isn't null.
+static const void *column_values(const ColumnFile &file, const std::string &name,
+                                 std::vector<double> *convert) {
+    const ColumnEntry *column = file.find(name);
+    if (column == NULL)
+        throw std::range_error("column file has no column " + name);
+    if (column->type != COLUMN_FLOAT64 && column->type != COLUMN_FLOAT32)
+        throw std::range_error("column " + name + " must be float64 or float32");
 
-        if (allclear) {
-            std::replace(k, k + window_len, false, true);
+    if (column->type == COLUMN_FLOAT64) return file.data(*column);
+    if (convert == NULL) return float32_values(file.data(*column));
+    convert->resize(file.size());
+    unpack_float32(file.data(*column), file.size(), convert->data());
+    return convert->data();
+}
+
+//' Clear sky detection on a column file
+//'
+//' The observed and predicted columns of the file are memory mapped and read
+//' in place, and the clear points are written back to the file as a bits
+//' column, without building any R vectors.
+//'
+//' @inheritParams clear_pts
+//' @param path Path of a column file, see \code{\link{write_clearsky}}.
+//' @param observed,predicted Names of the columns of measured and predicted
+//' irradiance, float64 or float32. float32 columns are only read in place if
+//' both are float32, otherwise the float32 one is converted.
+//' @param clear Name of the bits column to write the clear points to,
+//' replacing any column of that name.
+//'
+//' @return The number of clear points.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+double clear_pts_file(std::string path, Rcpp::List thresholds, int window_len,
+                      int threads = 1, std::string observed = "observed",
+                      std::string predicted = "predicted",
+                      std::string clear = "clear") {
+    if (threads <= 0)
+        throw std::range_error("threads must be a positive integer");
+    Thresholds bounds = to_thresholds(thresholds);
+
+    std::vector<unsigned char> bits;
+    double n_clear = 0;
+    {
+        ColumnFile file(path);
+        long n = file.size();
+        if (window_len <= 0 || window_len > n)
+            throw std::range_error("Incorrect value to window_len");
+
+        bits.assign(bit_bytes(n), 0);
+        auto set_clear = [&](long k) {
+            set_bit(bits.data(), k);
+            ++n_clear;
+        };
+
+        const ColumnEntry *x = file.find(observed), *cs = file.find(predicted);
+        if (x && cs && x->type == COLUMN_FLOAT32 && cs->type == COLUMN_FLOAT32) {
+            detect_flags((const float *) column_values(file, observed, NULL),
+                         (const float *) column_values(file, predicted, NULL), n,
+                         window_len, bounds, threads, 0, 90, set_clear);
+        } else {
+            std::vector<double> x_doubles, cs_doubles;
+            detect_flags((const double *) column_values(file, observed, &x_doubles),
+                         (const double *) column_values(file, predicted, &cs_doubles),
+                         n, window_len, bounds, threads, 0, 90, set_clear);
         }
+    }
+
+    append_column(path, clear, COLUMN_BITS, bits.data());
+    return n_clear;
+}
+
+// Check the arguments common to functions over every window of x and cs.
+void check_windows(Rcpp::NumericVector &x, Rcpp::NumericVector &cs, int window_len) {
+    if (x.size() != cs.size())
+        throw std::range_error("x must be the same length as cs");
+    if (window_len <= 0 || window_len > x.size())
+        throw std::range_error("Incorrect value to window_len");
+}
+
+// Interrupt check for window_criteria on the main thread.
+bool check_interrupt() {
+    Rcpp::checkUserInterrupt();
+    return false;
+}
+
+//' Calculate the criterion of every window.
+//'
+//' The rolling window calculation of the five clear sky criterion is done
+//' once, and the result may be reused, for example by
+//' \code{\link{sweep_thresholds}}.
+//'
+//' @inheritParams clear_pts
+//' @param float32 If TRUE, store the criterion as 32 bit floats, taking half
+//' the memory. The values are then accurate to about 7 significant digits.
+//'
+//' @return A matrix with one row for each window, starting at each of
+//' points 1 to length(x) - window_len + 1, and one column for each
+//' criterion, ordered as the thresholds of \code{\link{clear_points}}. The
+//' criterion of windows containing an NA are NaN. If float32 is TRUE, the matrix is stored in a raw vector of class 'float32',
+//' which may be converted with \code{as.matrix}.
+//'
+//' @export
+// [[Rcpp::export]]
+SEXP criteria_matrix(Rcpp::NumericVector x, Rcpp::NumericVector cs, int window_len,
+                     bool float32 = false) {
+    check_windows(x, cs, window_len);
+
+    long n_windows = x.size() - window_len + 1;
+    Rcpp::List dimnames = Rcpp::List::create(R_NilValue, criterion_names());
+
+    if (float32) {
+        Rcpp::RawVector criteria(n_windows * N_CRITERION * FLOAT32_SIZE);
+        unsigned char *out = criteria.begin();
+        window_criteria(x.begin(), cs.begin(), n_windows, window_len,
+                        [&](long i, const double *criterion) {
+                            for (int j = 0; j < N_CRITERION; ++j) {
+                                pack_float32(criterion + j, 1,
+                                             out + (i + j * n_windows) * FLOAT32_SIZE);
+                            }
+                        }, check_interrupt);
+
+        criteria.attr("dim32") = Rcpp::IntegerVector::create(n_windows, N_CRITERION);
+        criteria.attr("dimnames32") = dimnames;
+        criteria.attr("class") = "float32";
+        return criteria;
+    }
+
+    Rcpp::NumericMatrix criteria(n_windows, N_CRITERION);
+    double *out = criteria.begin();
+    window_criteria(x.begin(), cs.begin(), n_windows, window_len,
+                    [&](long i, const double *criterion) {
+                        for (int j = 0; j < N_CRITERION; ++j) {
+                            out[i + j * n_windows] = criterion[j];
+                        }
+                    }, check_interrupt);
+
+    criteria.attr("dimnames") = dimnames;
+    return criteria;
+}
+
+// Criterion of each window from a criteria_matrix result, as consecutive
+// groups of N_CRITERION values.
+std::vector<double> criteria_rows(SEXP criteria, long n_windows) {
+    std::vector<double> values;
+    if (Rf_inherits(criteria, "float32")) {
+        Rcpp::RawVector packed(criteria);
+        values.resize(packed.size() / FLOAT32_SIZE);
+        unpack_float32(packed.begin(), values.size(), values.data());
+    } else {
+        Rcpp::NumericVector matrix(criteria);
+        values.assign(matrix.begin(), matrix.end());
+    }
+
+    if ((long) values.size() != n_windows * N_CRITERION)
+        throw std::range_error("criteria must have one row for each window of x");
 
+    std::vector<double> rows(values.size());
+    for (long i = 0; i < n_windows; ++i) {
+        for (int j = 0; j < N_CRITERION; ++j) {
+            rows[i * N_CRITERION + j] = values[i + j * n_windows];
+        }
+    }
+    return rows;
+}
+
+// Flag the clear points of each group of x and cs, where group g is points
+// [starts[g], starts[g + 1]); see clear_pts_grouped.
+template <typename Sample>
+Rcpp::LogicalVector detect_groups(const Sample *px, const Sample *pcs,
+                                  const std::vector<long> &starts, int window_len,
+                                  const Thresholds &bounds, int threads) {
+    int n_groups = starts.size() - 1;
+    std::vector<unsigned char> marks(starts.back(), 0);
+
+    // detect the clear points of group g, writing to its part of marks
+    auto detect_group = [&](int g, const std::atomic<bool> *cancel) {
+        long first = starts[g], last = starts[g + 1];
+        if (last - first < window_len) return;
+
+        detect_clear(px + first, pcs + first, 0, last - first - window_len + 1,
+                     window_len, bounds, marks.data() + first, [cancel]() {
+                         if (cancel) return cancel->load();
+                         Rcpp::checkUserInterrupt();
+                         return false;
+                     });
+    };
+
+    if (threads == 1 || n_groups <= 1) {
+        for (int g = 0; g < n_groups; ++g) {
+            detect_group(g, NULL);
+            Rcpp::checkUserInterrupt();
+        }
+    } else {
+        // groups may differ greatly in length, so each thread takes the next
+        // group when it finishes one
+        std::atomic<int> next(0);
+        run_parallel(std::min(threads, n_groups),
+                     [&](int, const std::atomic<bool> &cancel) {
+                         for (int g = next++; g < n_groups && !cancel; g = next++) {
+                             detect_group(g, &cancel);
+                         }
+                     });
+    }
+
+    return Rcpp::LogicalVector(marks.begin(), marks.end());
+}
+
+//' Grouped clear sky detection
+//'
+//' Run clear sky detection separately on each of a number of series stored
+//' one after the other in x and cs, such as several sites or days. Windows
+//' never span two series.
+//'
+//' @inheritParams clear_pts
+//' @param offsets Numeric vector of the index, from 0, at which each series
+//' starts, followed by the length of x. Series shorter than window_len have
+//' no clear points.
+//' @param threads Number of threads to run detection on. Series are handed
+//' to threads as they become free.
+//'
+//' @return A logical vector of the same length as x, each series the same as
+//' the result of \code{\link{clear_pts}} for that series alone.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::LogicalVector clear_pts_grouped(SEXP x, SEXP cs,
+                                      Rcpp::NumericVector offsets,
+                                      Rcpp::List thresholds, int window_len,
+                                      int threads = 1) {
+    Series obs(x), pred(cs);
+    long n = obs.size();
+
+    if (n != pred.size())
+        throw std::range_error("x must be the same length as cs");
+    if (window_len <= 0)
+        throw std::range_error("Incorrect value to window_len");
+    if (threads <= 0)
+        throw std::range_error("threads must be a positive integer");
+    // offsets are whole numbers, checked before conversion rather than
+    // truncated, and NaN fails every comparison
+    std::vector<long> starts;
+    for (long g = 0; g < offsets.size(); ++g) {
+        double at = offsets[g];
+        double prev = g > 0 ? offsets[g - 1] : 0;
+        if (!(at >= prev && at <= n && at == std::floor(at)))
+            throw std::range_error("offsets must increase from 0 to the length of x");
+        starts.push_back((long) at);
+    }
+    if (starts.empty() || starts.front() != 0 || starts.back() != n)
+        throw std::range_error("offsets must increase from 0 to the length of x");
+
+    Thresholds bounds = to_thresholds(thresholds);
+
+    if (obs.is_float32() && pred.is_float32()) {
+        return detect_groups(obs.floats(), pred.floats(), starts, window_len,
+                             bounds, threads);
+    }
+    return detect_groups(obs.doubles(), pred.doubles(), starts, window_len,
+                         bounds, threads);
+}
+
+//' Clear sky segments
+//'
+//' Run clear sky detection, returning the runs of consecutive clear points
+//' rather than a flag for every point.
+//'
+//' @inheritParams clear_pts
+//'
+//' @return A data frame with columns start and end, the first and last index
+//' of each run of clear points, inclusive. The points are the same as the
+//' TRUE values of \code{\link{clear_points}}.
+//'
+//' @export
+// [[Rcpp::export]]
+Rcpp::DataFrame clear_segments(Rcpp::NumericVector x, Rcpp::NumericVector cs,
+                               Rcpp::List thresholds, int window_len) {
+    check_windows(x, cs, window_len);
+    Thresholds bounds = to_thresholds(thresholds);
+
+    std::vector< std::pair<long, long> > runs;
+    clear_runs(x.begin(), cs.begin(), x.size() - window_len + 1, window_len,
+               bounds, runs, check_interrupt);
+
+    Rcpp::NumericVector start(runs.size()), end(runs.size());
+    for (size_t i = 0; i < runs.size(); ++i) {
+        start[i] = runs[i].first + 1;
+        end[i] = runs[i].second + 1;
+    }
+
+    return Rcpp::DataFrame::create(Rcpp::Named("start") = start,
+                                   Rcpp::Named("end") = end);
+}
+
+//' Clear sky detection for many sets of thresholds
+//'
+//' The criterion of every window are calculated once, and then compared to
+//' each set of thresholds in turn.
+//'
+//' @inheritParams clear_pts
+//' @param threshold_sets List of thresholds, each a list ordered as the
+//' thresholds of \code{\link{clear_pts}}.
+//' @param criteria Optional result of \code{\link{criteria_matrix}} for x,
+//' cs and window_len, used rather than calculating the criterion again.
+//'
+//' @return A logical matrix with one row per point of x, and one column per
+//' set of thresholds, each column the same as \code{\link{clear_pts}}
+//' for that set.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::LogicalMatrix clear_pts_sweep(Rcpp::NumericVector x, Rcpp::NumericVector cs,
+                                    Rcpp::List threshold_sets, int window_len,
+                                    SEXP criteria = R_NilValue) {
+    check_windows(x, cs, window_len);
+
+    int n = x.size();
+    int n_sets = threshold_sets.size();
+
+    std::vector<Thresholds> bounds(n_sets);
+    for (int k = 0; k < n_sets; ++k) {
+        Rcpp::List thresholds = threshold_sets[k];
+        bounds[k] = to_thresholds(thresholds);
+    }
+
+    long n_windows = n - window_len + 1;
+    std::vector<double> rows;
+    if (Rf_isNull(criteria)) {
+        rows.resize(n_windows * N_CRITERION);
+        window_criteria(x.begin(), cs.begin(), n_windows, window_len,
+                        [&rows](long i, const double *criterion) {
+                            std::copy(criterion, criterion + N_CRITERION,
+                                      rows.begin() + i * N_CRITERION);
+                        }, check_interrupt);
+    } else {
+        rows = criteria_rows(criteria, n_windows);
+    }
+
+    Rcpp::LogicalMatrix clear(n, n_sets);
+    for (int k = 0; k < n_sets; ++k) {
+        mark_clear(rows.data(), n_windows, window_len, bounds[k],
+                   clear.begin() + (long) k * n);
         Rcpp::checkUserInterrupt();
     }
 
     return clear;
 }
 
+//' Streaming clear sky detection
+//'
+//' Create a detector for clear sky detection over a series that arrives a
+//' few samples at a time, such as live telemetry. Samples are passed to
+//' \code{\link{detector_push}}, which returns the flags of the points that
+//' can no longer be covered by a later window. Only the current window is
+//' kept between calls.
+//'
+//' @inheritParams clear_pts
+//'
+//' @return An external pointer of class 'clear_detector'. The pointer is not
+//' valid after being saved and reloaded.
+//'
+//' @seealso \code{\link{clear_pts}}, which gives the same flags for a
+//' complete series.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::XPtr<StreamingDetector> clear_detector(Rcpp::List thresholds, int window_len) {
+    if (window_len <= 0)
+        throw std::range_error("Incorrect value to window_len");
+
+    Rcpp::XPtr<StreamingDetector> detector(
+        new StreamingDetector(window_len, to_thresholds(thresholds)));
+    detector.attr("class") = "clear_detector";
+    return detector;
+}
+
+// The detector held by an external pointer.
+StreamingDetector &as_detector(Rcpp::XPtr<StreamingDetector> &detector) {
+    if (!detector.inherits("clear_detector")) {
+        throw std::range_error("detector must be created by clear_detector()");
+    }
+    if (detector.get() == NULL) {
+        throw std::range_error("detector is no longer valid, it must be recreated");
+    }
+    return *detector;
+}
+
+// Final flags taken from detector. Attribute start is the index, from 1, of
+// the first point in the series.
+Rcpp::LogicalVector take_flags(StreamingDetector &detector) {
+    long start = detector.taken() + 1;
+    std::vector<unsigned char> flags;
+    detector.take(flags);
+
+    Rcpp::LogicalVector clear(flags.begin(), flags.end());
+    clear.attr("start") = (double) start;
+    return clear;
+}
+
+//' Add samples to a streaming clear sky detector.
+//'
+//' @param detector Detector created by \code{\link{clear_detector}}.
+//' @param x Numeric vector of new measured irradiance values.
+//' @param cs Numeric vector of predicted irradiance for the same points.
+//' @param flush If TRUE, the series ends after these samples, and the flags
+//' of all remaining points are returned.
+//'
+//' @return A logical vector of the points whose flags are final, which is
+//' empty until a full window has been pushed. Flags are returned in order,
+//' each exactly once; attribute start gives the index of the first of them in
+//' the series.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::LogicalVector detector_push(Rcpp::XPtr<StreamingDetector> detector,
+                                  Rcpp::NumericVector x, Rcpp::NumericVector cs,
+                                  bool flush = false) {
+    StreamingDetector &d = as_detector(detector);
+
+    if (x.size() != cs.size())
+        throw std::range_error("x must be the same length as cs");
+
+    for (int i = 0; i < x.size(); ++i) {
+        d.push(x[i], cs[i]);
+    }
+    if (flush) {
+        d.flush();
+    }
+
+    return take_flags(d);
+}
+
+//' Iterative clear sky detection
+//'
+//' Detect clear points, rescale cs to fit x over them, and repeat until the
+//' clear points settle. The criterion terms of x, and those of cs that scale
+//' in proportion, are calculated once; each iteration only recalculates the
+//' line length and slope deviation terms of the rescaled cs.
+//'
+//' @inheritParams clear_pts
+//' @param max_iter Maximum number of iterations.
+//' @param tolerance Converged once the scale changes by at most tolerance,
+//' relative to the scale, or the clear points stay the same.
+//'
+//' @return The result of \code{\link{clear_pts}} for x and cs multiplied by
+//' the final scale, with attributes scale, the final scale; scales, the scale
+//' used by each iteration, starting at 1; and converged, FALSE if max_iter
+//' iterations were reached, or no point was clear.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::LogicalVector clear_pts_rescaled(SEXP x, SEXP cs, Rcpp::List thresholds,
+                                       int window_len, int max_iter = 20,
+                                       double tolerance = 1e-6) {
+    Series obs(x), pred(cs);
+    int n = obs.size();
+
+    if (n != pred.size())
+        throw std::range_error("x must be the same length as cs");
+    if (window_len <= 0 || window_len > n)
+        throw std::range_error("Incorrect value to window_len");
+    if (max_iter <= 0)
+        throw std::range_error("max_iter must be a positive integer");
+
+    Thresholds bounds = to_thresholds(thresholds);
+    const double *px = obs.doubles(), *pcs = pred.doubles();
+    Rescaling rescaling = rescaled_detection(px, pcs, n, window_len, bounds,
+                                             max_iter, tolerance, check_interrupt);
+
+    // the final points are calculated exactly as clear_pts would
+    std::vector<double> scaled(pcs, pcs + n);
+    for (double &v : scaled) v *= rescaling.scale;
+    Rcpp::LogicalVector clear = detect_points(px, (const double *) scaled.data(), n,
+                                              window_len, bounds, 1, 0, 90);
+
+    clear.attr("scale") = rescaling.scale;
+    clear.attr("scales") = Rcpp::wrap(rescaling.scales);
+    clear.attr("converged") = rescaling.converged;
+    return clear;
+}
+
 //' Root mean squared error
 //'
 //' Calculate root mean squared error.
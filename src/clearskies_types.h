@@ -0,0 +1,11 @@
+#ifndef CLEARSKIES_TYPES_H
+#define CLEARSKIES_TYPES_H
+
+// Types used in the signatures of exported functions, included by the
+// generated RcppExports.cpp.
+
+#include "detect.h"
+#include "solar.h"
+#include "turbidity.h"
+
+#endif
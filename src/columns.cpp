@@ -0,0 +1,288 @@
+#include <algorithm>   // remove_if
+#include <fstream>
+#include <stdexcept>   // range_error, runtime_error
+#include <vector>
+#include <string.h>    // memcpy, memcmp, memset, strncpy
+#include <Rcpp.h>
+#include "bits.h"
+#include "clearmask.h"
+#include "columns.h"
+#include "float32.h"
+
+static_assert(sizeof(ColumnHeader) == 72, "column file header must be 72 bytes");
+static_assert(sizeof(ColumnEntry) == 32, "column directory entries must be 32 bytes");
+
+uint64_t column_bytes(uint32_t type, uint64_t n) {
+    switch (type) {
+    case COLUMN_FLOAT64: return n * sizeof(double);
+    case COLUMN_FLOAT32: return n * FLOAT32_SIZE;
+    case COLUMN_BITS: return bit_bytes(n);
+    default: return 0;
+    }
+}
+
+static bool known_type(uint32_t type) {
+    return type == COLUMN_FLOAT64 || type == COLUMN_FLOAT32 || type == COLUMN_BITS;
+}
+
+ColumnFile::ColumnFile(const std::string &path) : file_(path) {
+    if (file_.size() < sizeof(header_)) {
+        throw std::runtime_error(path + " is not a column file");
+    }
+    memcpy(&header_, file_.data(), sizeof(header_));
+    if (memcmp(header_.magic, "CSKY", 4) != 0 || header_.version != COLUMNS_VERSION) {
+        throw std::runtime_error(path + " is not a column file");
+    }
+
+    uint64_t size = file_.size();
+    if (header_.directory > size ||
+        (size - header_.directory) / sizeof(ColumnEntry) < header_.n_columns) {
+        throw std::runtime_error(path + " is truncated");
+    }
+    columns_.resize(header_.n_columns);
+    if (header_.n_columns > 0) {
+        memcpy(columns_.data(), file_.data() + header_.directory,
+               columns_.size() * sizeof(ColumnEntry));
+    }
+
+    for (const ColumnEntry &column : columns_) {
+        if (!known_type(column.type) || column.offset % COLUMN_ALIGN != 0) {
+            throw std::runtime_error(path + " has an invalid column");
+        }
+        uint64_t bytes = column_bytes(column.type, header_.n);
+        if (column.offset > size || size - column.offset < bytes) {
+            throw std::runtime_error(path + " is truncated");
+        }
+    }
+}
+
+std::string ColumnFile::model() const {
+    return std::string(header_.model, strnlen(header_.model, sizeof(header_.model)));
+}
+
+const ColumnEntry *ColumnFile::find(const std::string &name) const {
+    for (const ColumnEntry &column : columns_) {
+        if (column_name(column) == name) return &column;
+    }
+    return NULL;
+}
+
+std::string column_name(const ColumnEntry &column) {
+    return std::string(column.name, strnlen(column.name, sizeof(column.name)));
+}
+
+void create_column_file(const std::string &path, uint64_t n, double interval,
+                        const std::string &model) {
+    ColumnHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "CSKY", 4);
+    header.version = COLUMNS_VERSION;
+    header.n = n;
+    header.directory = sizeof(header);
+    header.interval = interval;
+    strncpy(header.model, model.c_str(), sizeof(header.model) - 1);
+
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    if (!out)
+        throw std::runtime_error("Unable to write " + path);
+}
+
+void append_column(const std::string &path, const std::string &name, uint32_t type,
+                   const unsigned char *data) {
+    ColumnEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    if (name.empty() || name.size() >= sizeof(entry.name))
+        throw std::range_error("Column names must have 1 to 15 characters");
+    if (!known_type(type))
+        throw std::range_error("Unknown column type");
+    memcpy(entry.name, name.c_str(), name.size());
+    entry.type = type;
+
+    // read the directory through the mapping, which is closed before writing
+    ColumnHeader header;
+    std::vector<ColumnEntry> columns;
+    {
+        ColumnFile file(path);
+        header = file.header();
+        columns = file.columns();
+    }
+
+    std::fstream out(path.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    out.seekp(0, std::ios::end);
+    if (!out)
+        throw std::runtime_error("Unable to write " + path);
+
+    // pad to the alignment of the column
+    uint64_t end = out.tellp();
+    entry.offset = (end + COLUMN_ALIGN - 1) / COLUMN_ALIGN * COLUMN_ALIGN;
+    static const char padding[COLUMN_ALIGN] = {0};
+    out.write(padding, entry.offset - end);
+
+    uint64_t bytes = column_bytes(type, header.n);
+    out.write(reinterpret_cast<const char *>(data), bytes);
+
+    columns.erase(std::remove_if(columns.begin(), columns.end(),
+                                 [&name](const ColumnEntry &column) {
+                                     return column_name(column) == name;
+                                 }),
+                  columns.end());
+    columns.push_back(entry);
+    out.write(reinterpret_cast<const char *>(columns.data()),
+              columns.size() * sizeof(ColumnEntry));
+
+    // the header is written last, so until then the file is unchanged
+    header.directory = entry.offset + bytes;
+    header.n_columns = columns.size();
+    out.seekp(0);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.flush();
+    if (!out)
+        throw std::runtime_error("Unable to write " + path);
+}
+
+//' Write columns to a column file.
+//'
+//' Column files hold the observed, predicted and clear columns of a clearsky
+//' object, as in \code{\link{write_clearsky}}, and may be memory mapped, see
+//' \code{\link{clear_points_file}}.
+//'
+//' @param path Path of the file to write.
+//' @param columns Named list of columns, each either a numeric vector,
+//' written as doubles, a float32 vector, or a logical vector or clear mask,
+//' written as bits.
+//' NULL columns are left out. Names must have 1 to 15 characters.
+//' @param interval Minutes between points, or NA.
+//' @param model Name of the clear sky model. Only the first 31 characters are
+//' kept.
+//' @param append If TRUE, add the columns to the existing file at path,
+//' replacing any of the same name, rather than creating a new file.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+void write_columns(std::string path, Rcpp::List columns, double interval = NA_REAL,
+                   std::string model = "", bool append = false) {
+    SEXP column_names = columns.attr("names");
+    if (columns.size() > 0 && Rf_isNull(column_names))
+        throw std::range_error("columns must be named");
+    std::vector<std::string> names;
+    if (columns.size() > 0) names = Rcpp::as< std::vector<std::string> >(column_names);
+
+    // every column must have the points of the file
+    long n = -1;
+    if (append) {
+        n = ColumnFile(path).size();
+    }
+    for (int i = 0; i < columns.size(); ++i) {
+        SEXP column = columns[i];
+        if (Rf_isNull(column)) continue;
+        long length = Rf_length(column);
+        if (Rf_inherits(column, "float32")) {
+            length /= FLOAT32_SIZE;
+        } else if (Rf_inherits(column, "clearmask")) {
+            clear_mask_bits(column, &length);
+        }
+        if (n < 0) n = length;
+        if (length != n)
+            throw std::range_error("columns must all have the same number of points");
+    }
+    if (!append) {
+        create_column_file(path, n < 0 ? 0 : n, interval, model);
+    }
+
+    for (int i = 0; i < columns.size(); ++i) {
+        SEXP column = columns[i];
+        if (Rf_isNull(column)) continue;
+        const std::string &name = names[i];
+
+        if (Rf_inherits(column, "float32")) {
+            Rcpp::RawVector packed(column);
+            append_column(path, name, COLUMN_FLOAT32, packed.begin());
+        } else if (Rf_inherits(column, "clearmask")) {
+            long length;
+            append_column(path, name, COLUMN_BITS, clear_mask_bits(column, &length));
+        } else if (Rf_isLogical(column)) {
+            Rcpp::LogicalVector flags(column);
+            std::vector<unsigned char> bits(bit_bytes(n));
+            for (long k = 0; k < n; ++k) {
+                if (flags[k] == NA_LOGICAL)
+                    throw std::range_error("logical columns must not be NA");
+                if (flags[k]) set_bit(bits.data(), k);
+            }
+            append_column(path, name, COLUMN_BITS, bits.data());
+        } else if (Rf_isNumeric(column)) {
+            Rcpp::NumericVector values(column);
+            append_column(path, name, COLUMN_FLOAT64,
+                          reinterpret_cast<const unsigned char *>(values.begin()));
+        } else {
+            throw std::range_error("columns must be numeric, float32 or logical");
+        }
+    }
+}
+
+//' Read columns from a column file.
+//'
+//' @param path Path of a file written by \code{\link{write_columns}}.
+//' @param names Names of the columns to read, or NULL for all of them.
+//' @param packed If TRUE, read bits as clear masks, see
+//' \code{\link{as_clearmask}}, rather than unpacking them.
+//'
+//' @return A named list of the columns: doubles as numeric vectors, float32
+//' as float32 and bits as logical vectors, or clear masks if packed is TRUE.
+//' Attributes n, interval and model are those of the file.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::List read_columns(std::string path, SEXP names = R_NilValue,
+                        bool packed = false) {
+    ColumnFile file(path);
+    long n = file.size();
+
+    std::vector<const ColumnEntry *> wanted;
+    if (Rf_isNull(names)) {
+        for (const ColumnEntry &column : file.columns()) wanted.push_back(&column);
+    } else {
+        std::vector<std::string> asked = Rcpp::as< std::vector<std::string> >(names);
+        for (const std::string &name : asked) {
+            const ColumnEntry *column = file.find(name);
+            if (column == NULL)
+                throw std::range_error(path + " has no column " + name);
+            wanted.push_back(column);
+        }
+    }
+
+    Rcpp::List result(wanted.size());
+    Rcpp::CharacterVector result_names(wanted.size());
+    for (size_t i = 0; i < wanted.size(); ++i) {
+        const ColumnEntry &column = *wanted[i];
+        const unsigned char *data = file.data(column);
+        result_names[i] = column_name(column);
+
+        if (column.type == COLUMN_FLOAT64) {
+            Rcpp::NumericVector values(n);
+            memcpy(values.begin(), data, n * sizeof(double));
+            result[i] = values;
+        } else if (column.type == COLUMN_FLOAT32) {
+            Rcpp::RawVector packed(n * FLOAT32_SIZE);
+            memcpy(packed.begin(), data, n * FLOAT32_SIZE);
+            packed.attr("class") = "float32";
+            result[i] = packed;
+        } else if (packed) {
+            Rcpp::RawVector mask = new_clear_mask(n);
+            memcpy(mask.begin(), data, bit_bytes(n));
+            result[i] = mask;
+        } else {
+            Rcpp::LogicalVector flags(n);
+            for (long k = 0; k < n; ++k) {
+                flags[k] = get_bit(data, k);
+            }
+            result[i] = flags;
+        }
+    }
+
+    result.attr("names") = result_names;
+    result.attr("n") = (double) n;
+    result.attr("interval") = file.interval();
+    result.attr("model") = file.model();
+    return result;
+}
@@ -0,0 +1,106 @@
+#ifndef CLEARSKIES_COLUMNS_H
+#define CLEARSKIES_COLUMNS_H
+
+#include <stdint.h>    // uint32_t, uint64_t
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+
+// Columns of a clearsky object in a file, independent of the R API.
+//
+// The file starts with a 72 byte header, in native (little endian) byte
+// order:
+//
+//     char[4]   magic       "CSKY"
+//     uint32    version     1
+//     uint64    n           points in every column
+//     uint64    directory   offset of the column directory
+//     uint32    n_columns
+//     uint32    reserved    0
+//     float64   interval    minutes between points, NaN if unknown
+//     char[32]  model       name of the clear sky model, NUL padded
+//
+// The data of each column start at an offset that is a multiple of 64, so
+// a memory mapped column can be read in place. The directory follows the
+// last column, with 32 bytes for each column:
+//
+//     char[16]  name        NUL padded
+//     uint32    type        one of ColumnType
+//     uint32    reserved    0
+//     uint64    offset      of the column data
+//
+// Columns are added by appending their data and a new directory, then
+// pointing the header at it, so a column is added or replaced without
+// moving the others. The data of a replaced column, and the old directory,
+// are left unused in the file.
+struct ColumnHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t n;
+    uint64_t directory;
+    uint32_t n_columns;
+    uint32_t reserved;
+    double interval;
+    char model[32];
+};
+
+struct ColumnEntry {
+    char name[16];
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t offset;
+};
+
+const uint32_t COLUMNS_VERSION = 1;
+const uint64_t COLUMN_ALIGN = 64;
+
+// float64 and float32 values, as in float32.h, and flags packed as in bits.h.
+enum ColumnType { COLUMN_FLOAT64 = 1, COLUMN_FLOAT32 = 2, COLUMN_BITS = 3 };
+
+// Bytes of the data of a column of n values, or 0 if type isn't a ColumnType.
+uint64_t column_bytes(uint32_t type, uint64_t n);
+
+// A column file, memory mapped, so that only the columns read are ever read
+// from disk.
+class ColumnFile {
+public:
+    // Throws std::runtime_error if the file can't be read or isn't a column
+    // file.
+    explicit ColumnFile(const std::string &path);
+
+    const ColumnHeader &header() const { return header_; }
+    uint64_t size() const { return header_.n; }
+    double interval() const { return header_.interval; }
+    std::string model() const;
+
+    const std::vector<ColumnEntry> &columns() const { return columns_; }
+
+    // The column called name, or NULL if there is none.
+    const ColumnEntry *find(const std::string &name) const;
+
+    const unsigned char *data(const ColumnEntry &column) const {
+        return file_.data() + column.offset;
+    }
+
+private:
+    MappedFile file_;
+    ColumnHeader header_;
+    std::vector<ColumnEntry> columns_;
+};
+
+// Name of a column, without the padding.
+std::string column_name(const ColumnEntry &column);
+
+// Create a column file at path with no columns, replacing any file there.
+// Throws std::runtime_error if it can't be written.
+void create_column_file(const std::string &path, uint64_t n, double interval,
+                        const std::string &model);
+
+// Add column name of type to the column file at path, replacing any column
+// of that name. data holds the column_bytes(type, n) bytes of the column.
+// Throws std::runtime_error if the file can't be read or written, and
+// std::range_error if the name is too long or the type unknown.
+void append_column(const std::string &path, const std::string &name, uint32_t type,
+                   const unsigned char *data);
+
+#endif
@@ -0,0 +1,93 @@
+#include <algorithm>   // max
+#include <cmath>       // fabs, isnan, isinf
+#include "criterion.h"
+
+
+double slope_sigma(double slope_sum, double slope_sq, int m, double mean) {
+    if (m < 2) {
+        return 0.0;
+    }
+
+    double slope_mean = slope_sum / m;
+    double var = (slope_sq - m * slope_mean * slope_mean) / (m - 1);
+    double sd = var > 0 ? std::sqrt(var) : 0.0;
+    double sigma = sd / mean;
+
+    // catch division by 0
+    if (std::isnan(sigma) || std::isinf(sigma)) {
+        return 0.0;
+    }
+
+    return sigma;
+}
+
+double line_length(const double *x, int n) {
+    double len = 0.0;
+    for (int i = 1; i < n; ++i) {
+        len += segment_length(x[i] - x[i - 1]);
+    }
+    return len;
+}
+
+double slope_sigma(const double *x, int n) {
+    if (n < 1) {
+        return 0.0;
+    }
+
+    double sum = x[0];
+    double ssq = 0.0;
+    for (int i = 1; i < n; ++i) {
+        double s = x[i] - x[i - 1];
+        sum += x[i];
+        ssq += s*s;
+    }
+
+    // sum of the slopes telescopes
+    return slope_sigma(x[n - 1] - x[0], ssq, n - 1, sum / n);
+}
+
+double max_deviation(const double *x, const double *cs, int n) {
+    // deviations are non-negative, so start from 0. A window of a single
+    // point has no slopes and a deviation of 0, so with window_len = 1 points
+    // are judged on the other criterion alone, as they always have been
+    double dev = 0.0;
+    for (int i = 1; i < n; ++i) {
+        double s = x[i] - x[i - 1];
+        double d = cs[i] - cs[i - 1];
+        dev = std::max(dev, std::fabs(s - d));
+    }
+    return dev;
+}
+
+void window_criterion(const double *x, const double *cs, int n, double *out) {
+    double sum_x = x[0], sum_cs = cs[0];
+    double max_x = x[0], max_cs = cs[0];
+    double len_x = 0.0, len_cs = 0.0;
+    double ssq_x = 0.0, ssq_cs = 0.0;
+    double dev = 0.0;
+
+    for (int i = 1; i < n; ++i) {
+        double s = x[i] - x[i - 1];
+        double d = cs[i] - cs[i - 1];
+
+        sum_x += x[i];
+        sum_cs += cs[i];
+        max_x = std::max(max_x, x[i]);
+        max_cs = std::max(max_cs, cs[i]);
+        len_x += segment_length(s);
+        len_cs += segment_length(d);
+        ssq_x += s*s;
+        ssq_cs += d*d;
+        dev = std::max(dev, std::fabs(s - d));
+    }
+
+    double mean_x = sum_x / n;
+    double mean_cs = sum_cs / n;
+
+    out[0] = mean_x - mean_cs;      // mean difference
+    out[1] = max_x - max_cs;        // max difference
+    out[2] = len_x - len_cs;        // line length difference
+    out[3] = slope_sigma(x[n - 1] - x[0], ssq_x, n - 1, mean_x) -
+             slope_sigma(cs[n - 1] - cs[0], ssq_cs, n - 1, mean_cs);  // sigma difference
+    out[4] = dev;                   // max deviance
+}
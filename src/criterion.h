@@ -0,0 +1,34 @@
+#ifndef CLEARSKIES_CRITERION_H
+#define CLEARSKIES_CRITERION_H
+
+#include <cmath>    // sqrt
+
+// Clear sky criterion over raw arrays of n values.
+//
+// None of these allocate or touch the R API, so they are safe to call from
+// worker threads. The Rcpp wrappers in clearskies.cpp and the rolling window
+// engine are built on top of them.
+
+// Number of clear sky criterion, ordered as:
+// mean, max, line length, sigma, maximum deviation from clear sky slope
+const int N_CRITERION = 5;
+
+// Length of the line segment between two sequential points.
+// (t_(i+1) - t_(i))^2 is always 1
+inline double segment_length(double slope) {
+    return std::sqrt(slope*slope + 1);
+}
+
+// Normalized sample standard deviation of m slopes, given their sum and sum
+// of squares. Division by 0, or fewer than two slopes, gives 0.
+double slope_sigma(double slope_sum, double slope_sq, int m, double mean);
+
+double line_length(const double *x, int n);
+double slope_sigma(const double *x, int n);
+double max_deviation(const double *x, const double *cs, int n);
+
+// Calculate all five criterion in a single pass over x and cs, writing them
+// to out.
+void window_criterion(const double *x, const double *cs, int n, double *out);
+
+#endif
@@ -0,0 +1,72 @@
+#include <stdexcept>   // range_error
+#include <vector>
+#include <Rcpp.h>
+#include "bits.h"
+#include "clearmask.h"
+#include "decimate.h"
+
+//' Points of a series to plot.
+//'
+//' Decimates the series to about max_points points for plotting, keeping
+//' those of the minimum and maximum of each series in each of a range of
+//' buckets of points, and those either side of every change of clear and of
+//' every NA gap.
+//'
+//' @param series List of numeric vectors of the same length, such as the
+//' observed and predicted irradiance.
+//' @param clear Optional logical vector, or clear mask, of the clear points.
+//' @param max_points Number of points to plot, about. Each change of clear,
+//' and the start and end of each gap, adds two. Inf plots every point.
+//'
+//' @return A numeric vector of the indices, from 1 and in order, of the points
+//' to plot. Every index if the series have at most max_points points.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::NumericVector plot_points(Rcpp::List series, SEXP clear = R_NilValue,
+                                double max_points = 4000) {
+    if (!(max_points >= 1))
+        throw std::range_error("max_points must be positive");
+
+    std::vector<Rcpp::NumericVector> values;
+    std::vector<const double *> columns;
+    values.reserve(series.size());
+    long n = -1;
+    for (int s = 0; s < series.size(); ++s) {
+        Rcpp::NumericVector y = series[s];
+        if (n >= 0 && y.size() != n)
+            throw std::range_error("series must all have the same length");
+        n = y.size();
+        values.push_back(y);
+        columns.push_back(values.back().begin());
+    }
+    if (n < 0)
+        throw std::range_error("series must not be empty");
+
+    std::vector<long> keep;
+    // any more than n is every point, and Inf or huge values can't be cast
+    long points = max_points >= n ? n : (long) max_points;
+    if (Rf_isNull(clear)) {
+        keep = decimate(columns, n, points, [](long) { return false; });
+    } else if (Rf_inherits(clear, "clearmask")) {
+        long n_clear;
+        const unsigned char *bits = clear_mask_bits(clear, &n_clear);
+        if (n_clear != n)
+            throw std::range_error("clear must be the same length as the series");
+        keep = decimate(columns, n, points,
+                        [bits](long k) { return get_bit(bits, k); });
+    } else {
+        Rcpp::LogicalVector flags(clear);
+        if (flags.size() != n)
+            throw std::range_error("clear must be the same length as the series");
+        const int *pf = flags.begin();
+        keep = decimate(columns, n, points,
+                        [pf](long k) { return pf[k] == 1; });
+    }
+
+    Rcpp::NumericVector index(keep.size());
+    for (size_t i = 0; i < keep.size(); ++i) {
+        index[i] = keep[i] + 1;
+    }
+    return index;
+}
@@ -0,0 +1,75 @@
+#ifndef CLEARSKIES_DECIMATE_H
+#define CLEARSKIES_DECIMATE_H
+
+#include <algorithm>   // max, sort, unique
+#include <cmath>       // isnan
+#include <vector>
+
+// Decimation of series for plotting, independent of the R API.
+//
+// The points of n_series series of n points each are split into buckets of
+// consecutive points, and of each bucket only the points of the minimum and
+// maximum of each series are drawn, so the envelope of the lines is the same
+// as drawing every point. With a bucket for every pixel or two, the plot
+// looks the same.
+//
+// The points either side of every change of clear(k), and of the start and
+// end of every gap (NaN) of each series, are also drawn, so each line drawn
+// between two points is clear or not clear all along, and gaps aren't
+// bridged.
+
+// Sorted indices of the points to draw, about max_points of them plus two for
+// each change. If n is at most max_points, every point.
+template <typename Clear>
+std::vector<long> decimate(const std::vector<const double *> &series, long n,
+                           long max_points, Clear clear) {
+    std::vector<long> keep;
+    if (n <= max_points) {
+        keep.resize(n);
+        for (long k = 0; k < n; ++k) keep[k] = k;
+        return keep;
+    }
+
+    int n_series = series.size();
+    long n_buckets = std::max(1L, max_points / (2 * std::max(n_series, 1)));
+    for (long b = 0; b < n_buckets; ++b) {
+        long first = (long) ((double) b * n / n_buckets);
+        long last = (long) ((double) (b + 1) * n / n_buckets);
+
+        for (int s = 0; s < n_series; ++s) {
+            const double *y = series[s];
+            long lowest = -1, highest = -1;
+            for (long k = first; k < last; ++k) {
+                if (std::isnan(y[k])) continue;
+                if (lowest < 0 || y[k] < y[lowest]) lowest = k;
+                if (highest < 0 || y[k] > y[highest]) highest = k;
+            }
+            if (lowest >= 0) {
+                keep.push_back(lowest);
+                keep.push_back(highest);
+            }
+        }
+    }
+
+    keep.push_back(0);
+    keep.push_back(n - 1);
+    bool was_clear = clear(0);
+    for (long k = 1; k < n; ++k) {
+        bool is_clear = clear(k);
+        bool change = is_clear != was_clear;
+        for (int s = 0; s < n_series && !change; ++s) {
+            change = std::isnan(series[s][k]) != std::isnan(series[s][k - 1]);
+        }
+        if (change) {
+            keep.push_back(k - 1);
+            keep.push_back(k);
+        }
+        was_clear = is_clear;
+    }
+
+    std::sort(keep.begin(), keep.end());
+    keep.erase(std::unique(keep.begin(), keep.end()), keep.end());
+    return keep;
+}
+
+#endif
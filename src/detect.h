@@ -0,0 +1,416 @@
+#ifndef CLEARSKIES_DETECT_H
+#define CLEARSKIES_DETECT_H
+
+#include <math.h>      // INFINITY, NAN
+#include <algorithm>   // stable_sort
+#include <utility>     // pair, swap
+#include <vector>
+#include "criterion.h"
+#include "window.h"
+
+// Clear sky detection over a range of windows, independent of the R API.
+//
+// Missing samples, NA or NaN in either x or cs, are gaps in the series. A
+// window containing a gap is never clear, and has NaN criterion. Gaps aren't
+// pushed into the rolling window; it's reset instead, so windows after a gap
+// are evaluated once window_len valid samples have arrived, without ever
+// recalculating the windows spanning the gap.
+
+// Number of windows evaluated between calls to the stop condition, so that
+// interrupt checks stay out of the hot loop.
+const long INTERRUPT_INTERVAL = 16384;
+
+// Inclusive lower and upper bounds for each criterion, compiled once before
+// detection into a flat list of tests. Criterion without a finite bound can
+// never fail, so aren't tested.
+struct Thresholds {
+    struct Test {
+        int criterion;
+        double lower;
+        double upper;
+    };
+
+    Test tests[N_CRITERION];
+    int n_tests;
+
+    Thresholds() : n_tests(0) {}
+
+    Thresholds(const double *lower, const double *upper) : n_tests(0) {
+        for (int i = 0; i < N_CRITERION; ++i) {
+            if (lower[i] == -INFINITY && upper[i] == INFINITY) continue;
+            Test test = {i, lower[i], upper[i]};
+            tests[n_tests++] = test;
+        }
+    }
+};
+
+// True if sample i of x and cs is missing.
+template <typename Sample>
+inline bool is_gap(const Sample *x, const Sample *cs, long i) {
+    return x[i] != x[i] || cs[i] != cs[i];
+}
+
+// The first criterion tested that is outside its bounds, inclusive, or -1 if
+// all criterion are within their respective bounds. NaN criterion, of windows
+// containing a gap, are never within bounds, and fail on the mean.
+inline int failed_criterion(const double *criterion, const Thresholds &thresholds) {
+    if (criterion[0] != criterion[0]) {
+        return 0;
+    }
+    for (int i = 0; i < thresholds.n_tests; ++i) {
+        const Thresholds::Test &t = thresholds.tests[i];
+        if (!(criterion[t.criterion] >= t.lower && criterion[t.criterion] <= t.upper)) {
+            return t.criterion;
+        }
+    }
+    return -1;
+}
+
+// True if all criterion are within their respective bounds, inclusive.
+inline bool within_thresholds(const double *criterion, const Thresholds &thresholds) {
+    return failed_criterion(criterion, thresholds) < 0;
+}
+
+// Number of windows tested between reorderings of AdaptiveTests.
+const long ADAPT_INTERVAL = 1024;
+
+// The tests of a set of thresholds, applied to a rolling window one criterion
+// at a time, stopping at the first that fails.
+//
+// Tests start in order of cost: mean, max, deviation, line length, then
+// sigma. Every ADAPT_INTERVAL windows they are reordered by the number of
+// windows each rejected, so on cloudy data the most selective test runs
+// first. Rejections are halved on reordering, so the order follows changes
+// in the data, e.g. from day to night. Since a window must pass every test,
+// the order doesn't change which windows pass, only how soon the others are
+// turned down.
+class AdaptiveTests {
+public:
+    explicit AdaptiveTests(const Thresholds &thresholds)
+        : order_(thresholds), windows_(0) {
+        const int cost[N_CRITERION] = {0, 1, 3, 4, 2};
+        std::stable_sort(order_.tests, order_.tests + order_.n_tests,
+                         [&cost](const Thresholds::Test &a, const Thresholds::Test &b) {
+                             return cost[a.criterion] < cost[b.criterion];
+                         });
+        for (int i = 0; i < N_CRITERION; ++i) rejections_[i] = 0;
+    }
+
+    // As failed_criterion for the criterion of window, which must be full,
+    // calculating only the criterion that are tested.
+    int failed(const RollingWindow &window) {
+        if (++windows_ % ADAPT_INTERVAL == 0) adapt();
+
+        double mean = window.criterion(0);
+        if (mean != mean) {
+            return 0;
+        }
+        for (int i = 0; i < order_.n_tests; ++i) {
+            const Thresholds::Test &t = order_.tests[i];
+            double c = t.criterion == 0 ? mean : window.criterion(t.criterion);
+            if (!(c >= t.lower && c <= t.upper)) {
+                ++rejections_[i];
+                return t.criterion;
+            }
+        }
+        return -1;
+    }
+
+private:
+    Thresholds order_;
+    long rejections_[N_CRITERION];  // by position in order_
+    long windows_;
+
+    // Insertion sort by rejections, most first, keeping ties in their order.
+    void adapt() {
+        for (int i = 1; i < order_.n_tests; ++i) {
+            for (int j = i; j > 0 && rejections_[j] > rejections_[j - 1]; --j) {
+                std::swap(order_.tests[j], order_.tests[j - 1]);
+                std::swap(rejections_[j], rejections_[j - 1]);
+            }
+        }
+        for (int i = 0; i < order_.n_tests; ++i) rejections_[i] /= 2;
+    }
+};
+
+// Counts of the windows of a detect_clear call, by what became of them.
+struct DetectStats {
+    long evaluated;                 // windows whose criterion were calculated
+    long rejected[N_CRITERION];     // evaluated windows by failed criterion
+    long dark;                      // windows skipped as dark
+    long gaps;                      // windows skipped as containing a gap
+
+    DetectStats() : evaluated(0), dark(0), gaps(0) {
+        for (int c = 0; c < N_CRITERION; ++c) rejected[c] = 0;
+    }
+
+    void add(const DetectStats &other) {
+        evaluated += other.evaluated;
+        for (int c = 0; c < N_CRITERION; ++c) rejected[c] += other.rejected[c];
+        dark += other.dark;
+        gaps += other.gaps;
+    }
+};
+
+// Evaluate the windows starting at points [first, last) of x and cs, and
+// flag every point covered by a clear window. clear is indexed relative to
+// first, and all of its last - first + window_len - 1 flags are written.
+//
+// stop is called every INTERRUPT_INTERVAL windows; detection is abandoned,
+// returning false, if it returns true.
+//
+// If zenith is given, points with a zenith angle of at least max_zenith are
+// dark, and windows of only dark points are never clear. They aren't
+// evaluated, and the samples in the middle of a long dark run aren't pushed
+// into the rolling window at all. The window restarts at a multiple of
+// window_len, so the criterion of the other windows are exactly the same as
+// without zenith.
+//
+// Samples may be stored as float or double; the criterion are calculated in
+// double either way.
+//
+// If stats is given, each of the windows is counted in it.
+template <typename Sample, typename Stop>
+bool detect_clear(const Sample *x, const Sample *cs, long first, long last,
+                  int window_len, const Thresholds &thresholds,
+                  unsigned char *clear, Stop stop,
+                  const double *zenith = 0, double max_zenith = 90,
+                  DetectStats *stats = 0) {
+    RollingWindow window(window_len, first);
+    AdaptiveTests tests(thresholds);
+    long n = last + window_len - 1;
+
+    // rather than flagging every point of each clear window, keep the last
+    // point covered by a clear window. Once window i has been evaluated no
+    // later window covers point i, so each flag is written once, in order
+    long covered = first - 1;
+
+    // last point that isn't dark, and the last point of the current dark run
+    long light = zenith ? first - window_len : n;
+    long dark_end = first - 1;
+    // next point to push into the window
+    long resume = first;
+
+    // end is the last point of window i
+    for (long end = first; end < n; ++end) {
+        long i = end - window_len + 1;
+
+        if (zenith && !(zenith[end] >= max_zenith)) {
+            light = end;
+        }
+
+        if (light < i) {
+            // window i is dark, as are the following windows up to the end
+            // of the run. Skip to the multiple of window_len preceding the
+            // first window that isn't
+            if (end > dark_end) {
+                dark_end = end;
+                while (dark_end + 1 < n && zenith[dark_end + 1] >= max_zenith) {
+                    ++dark_end;
+                }
+                long next = dark_end + 2 - window_len;
+                next -= next % window_len;
+                if (next > end) {
+                    resume = next;
+                    window.reset(next);
+                }
+            }
+        }
+
+        bool evaluated = false;
+        if (end < resume) {
+            // skipped
+        } else if (is_gap(x, cs, end)) {
+            window.reset(end + 1);
+        } else {
+            window.push(x[end], cs[end]);
+            if (window.full() && light >= i) {
+                int failed = tests.failed(window);
+                if (failed < 0) {
+                    covered = end;
+                }
+                evaluated = true;
+                if (stats) {
+                    ++stats->evaluated;
+                    if (failed >= 0) ++stats->rejected[failed];
+                }
+            }
+        }
+
+        if (i < first) continue;
+        clear[i - first] = i <= covered;
+
+        if (stats && !evaluated) {
+            if (light < i) {
+                ++stats->dark;
+            } else {
+                ++stats->gaps;
+            }
+        }
+
+        if ((i - first + 1) % INTERRUPT_INTERVAL == 0 && stop()) {
+            return false;
+        }
+    }
+
+    for (long i = last; i < last + window_len - 1; ++i) {
+        clear[i - first] = i <= covered;
+    }
+
+    return true;
+}
+
+// Calculate the criterion of the windows starting at points [0, n_windows),
+// calling emit(i, criterion) with the N_CRITERION values of each window i,
+// which are NaN for windows containing a gap. stop is called as in
+// detect_clear.
+template <typename Emit, typename Stop>
+bool window_criteria(const double *x, const double *cs, long n_windows,
+                     int window_len, Emit emit, Stop stop) {
+    RollingWindow window(window_len);
+    double criterion[N_CRITERION];
+    double missing[N_CRITERION];
+    for (int c = 0; c < N_CRITERION; ++c) missing[c] = NAN;
+
+    for (long end = 0; end < window_len - 1; ++end) {
+        if (is_gap(x, cs, end)) {
+            window.reset(end + 1);
+        } else {
+            window.push(x[end], cs[end]);
+        }
+    }
+
+    for (long i = 0; i < n_windows; ++i) {
+        long end = i + window_len - 1;
+        if (is_gap(x, cs, end)) {
+            window.reset(end + 1);
+        } else {
+            window.push(x[end], cs[end]);
+        }
+
+        if (window.full()) {
+            window.criterion(criterion);
+            emit(i, criterion);
+        } else {
+            emit(i, missing);
+        }
+
+        if ((i + 1) % INTERRUPT_INTERVAL == 0 && stop()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Flag the points covered by a clear window, given the criterion of each
+// window as consecutive groups of N_CRITERION values. clear must have room for
+// n_windows + window_len - 1 flags, which are all written.
+template <typename Flag>
+void mark_clear(const double *criteria, long n_windows, int window_len,
+                const Thresholds &thresholds, Flag *clear) {
+    // last point covered by the most recent clear window
+    long covered = -1;
+    long n = n_windows + window_len - 1;
+
+    for (long i = 0; i < n; ++i) {
+        if (i < n_windows && within_thresholds(criteria + i * N_CRITERION, thresholds)) {
+            covered = i + window_len - 1;
+        }
+        clear[i] = i <= covered;
+    }
+}
+
+// Append the runs of consecutive clear points to runs, as pairs of first and
+// last point, inclusive. The points are the same as flagged by detect_clear
+// for windows [0, n_windows). stop is called as in detect_clear.
+template <typename Stop>
+bool clear_runs(const double *x, const double *cs, long n_windows, int window_len,
+                const Thresholds &thresholds,
+                std::vector< std::pair<long, long> > &runs, Stop stop) {
+    return window_criteria(x, cs, n_windows, window_len,
+                           [&](long i, const double *criterion) {
+                               if (!within_thresholds(criterion, thresholds)) return;
+
+                               long end = i + window_len - 1;
+                               if (!runs.empty() && i <= runs.back().second + 1) {
+                                   runs.back().second = end;
+                               } else {
+                                   runs.push_back(std::make_pair(i, end));
+                               }
+                           }, stop);
+}
+
+// Clear sky detection over a series that arrives a few samples at a time.
+//
+// Gives the same flags as detect_clear over the whole series, but only keeps
+// the current window. A point's flag is final once no later window can cover
+// it, window_len - 1 samples after it arrives; final flags are handed out by
+// take(), in order.
+class StreamingDetector {
+public:
+    StreamingDetector(int window_len, const Thresholds &thresholds)
+        : window_(window_len), window_len_(window_len), tests_(thresholds),
+          count_(0), taken_(0), series_start_(0), pending_(0), covered_(-1) {}
+
+    void push(double x, double cs) {
+        ++count_;
+
+        if (x != x || cs != cs) {
+            // no later window covers this point, or any before it
+            window_.reset(count_ - series_start_);
+            finalize(count_);
+            return;
+        }
+
+        window_.push(x, cs);
+        if (window_.full()) {
+            if (tests_.failed(window_) < 0) {
+                covered_ = count_ - 1;
+            }
+
+            // no later window covers the oldest point of this one
+            finalize(count_ - window_len_ + 1);
+        }
+    }
+
+    // Mark every pending point as final, for the end of the series. Pushing
+    // further samples starts a new series.
+    void flush() {
+        finalize(count_);
+        window_.reset();
+        series_start_ = count_;
+    }
+
+    // Move the flags that have become final since the last call to out.
+    void take(std::vector<unsigned char> &out) {
+        out.swap(final_);
+        final_.clear();
+        taken_ += out.size();
+    }
+
+    // Number of samples pushed, and of flags taken.
+    long count() const { return count_; }
+    long taken() const { return taken_; }
+
+private:
+    RollingWindow window_;
+    int window_len_;
+    AdaptiveTests tests_;
+    long count_;
+    long taken_;
+    long series_start_;     // index of the first sample since the last flush
+    long pending_;          // first point whose flag isn't final
+    long covered_;          // last point covered by a clear window
+
+    std::vector<unsigned char> final_;      // final flags not yet taken
+
+    // Mark the points before end as final.
+    void finalize(long end) {
+        for (; pending_ < end; ++pending_) {
+            final_.push_back(pending_ <= covered_);
+        }
+    }
+};
+
+#endif
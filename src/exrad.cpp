@@ -1,27 +1,43 @@
+#include <algorithm>   // fill
+#include <stdexcept>   // range_error
+#include <vector>
 #include <Rcpp.h>
+#include "altrep.h"
+#include "solar.h"
 
 //' Helper function for calculating solar irradiance in clear sky models.
 //'
 //' @param dayofyear Day of year to calculate solar irradiance for. May be a
 //' vector.
 //' @param times Length of return vector. Passed to \emph{rep}.
+//' @param compact If TRUE, return a compact series, holding one value per
+//' day rather than times values. See \code{\link{zenith}}.
 //'
 //' @return A vector of earth radius values of length times.
 //'
 //' @keywords internal
 // [[Rcpp::export]]
-Rcpp::NumericVector exrad(Rcpp::NumericVector dayofyear, int times) {
-    const double deg2rad = M_PI / 180;
+SEXP exrad(Rcpp::NumericVector dayofyear, int times, bool compact = false) {
+    if (!compact) {
+        Rcpp::NumericVector ret(dayofyear.size() * times);
 
-    Rcpp::NumericVector dayangle = 360.0 * (dayofyear - 1.0) / 365.0;
-    Rcpp::NumericVector d2 = 2.0 * dayangle;
+        auto it = ret.begin();
+        for (auto d = dayofyear.begin(); d != dayofyear.end(); ++d, it += times) {
+            std::fill(it, it + times, extraterrestrial(*d));
+        }
+        return ret;
+    }
 
-    // Earth radius vector * solar constant = solar energy
-    Rcpp::NumericVector erv = 1.00011 + (0.034221 * Rcpp::cos(deg2rad * dayangle)) + (0.00128 * Rcpp::sin(deg2rad * dayangle));
-    erv += 0.000719 * (Rcpp::cos(deg2rad * d2)) + (0.000077 * Rcpp::sin(deg2rad * d2));
-    erv = 1366.1 * erv;
+    if (times < 1) throw std::range_error("times must be positive for a compact series");
 
-    Rcpp::NumericVector ret = rep_each(erv, times);
-    return ret;
+    // one run of times values per day, without universal times
+    std::vector<TimeRun> runs(dayofyear.size());
+    for (int d = 0; d < dayofyear.size(); ++d) {
+        TimeRun run = {NA_REAL, dayofyear[d], (long) d * times, times, d, NULL};
+        runs[d] = run;
+    }
+    return compact_series(runs, NULL, 0, (long) dayofyear.size() * times,
+                          [](const TimeRun &run, double *out) {
+                              std::fill(out, out + run.n, extraterrestrial(run.dayofyear));
+                          });
 }
-
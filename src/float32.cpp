@@ -0,0 +1,56 @@
+#include <stdexcept>   // range_error
+#include <Rcpp.h>
+#include "float32.h"
+
+//' Convert float32 values to doubles.
+//'
+//' @param x Raw vector of class 'float32'. If x has attribute dim32, the
+//' values are a matrix of that size, with dimnames from attribute dimnames32.
+//'
+//' @return A numeric vector or matrix of the values of x.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::NumericVector float32_to_double(Rcpp::RawVector x) {
+    if (x.size() % FLOAT32_SIZE != 0)
+        throw std::range_error("x must have a multiple of 4 bytes");
+
+    long n = x.size() / FLOAT32_SIZE;
+    Rcpp::NumericVector values(n);
+    unpack_float32(x.begin(), n, values.begin());
+
+    if (x.hasAttribute("dim32")) {
+        values.attr("dim") = x.attr("dim32");
+        if (x.hasAttribute("dimnames32"))
+            values.attr("dimnames") = x.attr("dimnames32");
+    }
+    return values;
+}
+
+//' Store numeric values as 32 bit floats.
+//'
+//' Halves the memory of long series, such as observed or predicted
+//' irradiance, which can then be passed to \code{\link{clear_points}}
+//' directly. Values are rounded to the nearest float, accurate to about 7
+//' significant digits; NA becomes NaN.
+//'
+//' @param x Numeric vector or matrix.
+//'
+//' @return A raw vector of class 'float32', holding 4 bytes for each value of
+//' x. The dimensions of a matrix are kept in attributes dim32 and dimnames32.
+//' Use \code{as.double} or \code{as.matrix} to convert back.
+//'
+//' @export
+// [[Rcpp::export]]
+Rcpp::RawVector as_float32(Rcpp::NumericVector x) {
+    Rcpp::RawVector packed(x.size() * FLOAT32_SIZE);
+    pack_float32(x.begin(), x.size(), packed.begin());
+
+    if (x.hasAttribute("dim")) {
+        packed.attr("dim32") = x.attr("dim");
+        if (x.hasAttribute("dimnames"))
+            packed.attr("dimnames32") = x.attr("dimnames");
+    }
+    packed.attr("class") = "float32";
+    return packed;
+}
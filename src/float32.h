@@ -0,0 +1,35 @@
+#ifndef CLEARSKIES_FLOAT32_H
+#define CLEARSKIES_FLOAT32_H
+
+#include <string.h>    // memcpy
+
+// Compact storage of doubles as 32 bit floats, independent of the R API.
+//
+// R has no single precision type, so float32 values are kept as 4 bytes each
+// in a raw vector. Values are rounded to the nearest float; the relative
+// error is at most 6e-8. Calculations on them are done in double.
+
+const int FLOAT32_SIZE = 4;
+
+inline void pack_float32(const double *in, long n, unsigned char *out) {
+    for (long i = 0; i < n; ++i) {
+        float f = (float) in[i];
+        memcpy(out + i * FLOAT32_SIZE, &f, FLOAT32_SIZE);
+    }
+}
+
+inline void unpack_float32(const unsigned char *in, long n, double *out) {
+    for (long i = 0; i < n; ++i) {
+        float f;
+        memcpy(&f, in + i * FLOAT32_SIZE, FLOAT32_SIZE);
+        out[i] = f;
+    }
+}
+
+// The values packed by pack_float32, read in place. R aligns the data of
+// every vector for doubles, so the values are suitably aligned for floats.
+inline const float *float32_values(const unsigned char *in) {
+    return reinterpret_cast<const float *>(in);
+}
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef CLEARSKIES_MAPPED_FILE_H
+#define CLEARSKIES_MAPPED_FILE_H
+
+#include <stddef.h>    // size_t
+#include <string>
+
+// A read only memory mapping of a whole file, independent of the R API.
+//
+// Pages are loaded by the operating system as they are first read, so
+// opening a large file is cheap and only the parts actually used are ever
+// read from disk.
+class MappedFile {
+public:
+    // Throws std::runtime_error if the file can't be opened or mapped.
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    const unsigned char *data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+
+    const unsigned char *data_;
+    size_t size_;
+#ifdef _WIN32
+    void *mapping_;
+#endif
+};
+
+#endif
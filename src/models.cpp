@@ -0,0 +1,229 @@
+#include <algorithm>   // copy, fill
+#include <stdexcept>   // range_error
+#include <vector>
+#include <Rcpp.h>
+#include "altrep.h"
+#include "models.h"
+#include "solar.h"
+#include "zenith.h"
+
+// GHI of model at loc for each point of run, written to g. The zenith angles
+// are written to g, then replaced by GHI.
+template <typename Model>
+void fit_run(const TimeRun &run, const Location &loc, ZenithMethod method,
+             const Model &model, double *g) {
+    if (ISNAN(run.julday)) {
+        std::fill(g, g + run.n, NA_REAL);
+        return;
+    }
+
+    double io = extraterrestrial(run.dayofyear);
+    zenith_run(run, loc, method, g);
+    if (method == ZENITH_VECTORIZED) {
+        model_vectorized(model, io, g, run.n);
+        return;
+    }
+    for (long t = 0; t < run.n; ++t) {
+        g[t] = model(g[t], io);
+    }
+}
+
+// GHI at each interval throughout the given days, or at each of time if
+// given, fused with the zenith angle calculation so that no intermediate
+// vectors are built. day_model(i) returns the model for the i'th element of
+// dayofyear, or of time.
+//
+// The extraterrestrial irradiance is taken from dayofyear alone, recycled
+// over the combined days as in exrad, or from the local day of time.
+//
+// vectorized and fast choose the zenith angle calculation, as in zenith, and
+// if vectorized the model is calculated by model_vectorized too. If float32,
+// the values are returned as float32, packed a day at a time. If compact,
+// they are returned as a compact series, fit a day at a time when read, so day_model is kept with the series and must not refer to locals.
+template <typename DayModel>
+SEXP fit_model(Rcpp::NumericVector dayofyear, Rcpp::NumericVector year,
+               double tz, double latitude, double longitude,
+               double interval, bool vectorized, bool float32, SEXP time,
+               bool compact, bool fast, DayModel day_model) {
+    if (compact && float32)
+        throw std::range_error("compact series can't be float32");
+    ZenithMethod method = zenith_method(vectorized, fast);
+
+    std::vector<TimeRun> runs;
+    std::vector<double> utime;
+    SharedTimes universaltime;
+    long n_values = 0;
+
+    if (!Rf_isNull(time)) {
+        Rcpp::NumericVector times(time);
+        runs = time_runs(times, tz, utime);
+        n_values = times.size();
+    } else {
+        universaltime = universal_gmt(interval, tz);
+        if (dayofyear.size() > 0 && year.size() > 0) {
+            SharedTimes julday = julian_day(dayofyear, year);
+            runs = grid_runs(*julday, dayofyear, *universaltime);
+            n_values = (long) julday->size() * universaltime->size();
+        }
+    }
+
+    Location loc(latitude, longitude);
+
+    if (compact) {
+        const double *base = Rf_isNull(time) ? universaltime->data() : utime.data();
+        long n_base = Rf_isNull(time) ? universaltime->size() : utime.size();
+        return compact_series(runs, base, n_base, n_values,
+                              [loc, method, day_model](const TimeRun &run, double *g) {
+                                  fit_run(run, loc, method, day_model(run.element), g);
+                              });
+    }
+
+    SeriesWriter out(n_values, float32);
+    for (const TimeRun &run : runs) {
+        fit_run(run, loc, method, day_model(run.element), out.block(run.first, run.n));
+    }
+    return out.result();
+}
+
+//' Fit the Adnot-Bourges-Campana-Gicquel clear sky model.
+//'
+//' @inheritParams zenith
+//' @param a,b Model parameters.
+//' @param time Optional times to fit the model at, either POSIXct or seconds
+//' since 1970-01-01 UTC, instead of every interval of dayofyear and year,
+//' which are then ignored. See \code{\link{zenith_times}}.
+//' @param compact If TRUE, return a compact series, fit a day at a time when
+//' read. See \code{\link{zenith}}.
+//' @param fast If TRUE, interpolate the time only terms of the zenith angle
+//' between hours. See \code{\link{zenith}}.
+//'
+//' @return Vector of fitted irradiance values for the given time period.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+SEXP abcg_model(Rcpp::NumericVector dayofyear, Rcpp::NumericVector year,
+                double tz, double latitude, double longitude,
+                double interval, double a, double b,
+                bool vectorized = false, bool float32 = false,
+                SEXP time = R_NilValue, bool compact = false,
+                bool fast = false) {
+    ABCGModel model = {a, b};
+    return fit_model(dayofyear, year, tz, latitude, longitude, interval,
+                     vectorized, float32, time, compact, fast,
+                     [model](long) { return model; });
+}
+
+//' Fit the Robledo-Soler clear sky model.
+//'
+//' @inheritParams zenith
+//' @param a,b,c Model parameters.
+//' @param time Optional times to fit the model at, either POSIXct or seconds
+//' since 1970-01-01 UTC, instead of every interval of dayofyear and year,
+//' which are then ignored. See \code{\link{zenith_times}}.
+//' @param compact If TRUE, return a compact series, fit a day at a time when
+//' read. See \code{\link{zenith}}.
+//' @param fast If TRUE, interpolate the time only terms of the zenith angle
+//' between hours. See \code{\link{zenith}}.
+//'
+//' @return Vector of fitted irradiance values for the given time period.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+SEXP rs_model(Rcpp::NumericVector dayofyear, Rcpp::NumericVector year,
+              double tz, double latitude, double longitude,
+              double interval, double a, double b, double c,
+              bool vectorized = false, bool float32 = false,
+              SEXP time = R_NilValue, bool compact = false,
+              bool fast = false) {
+    RSModel model = {a, b, c};
+    return fit_model(dayofyear, year, tz, latitude, longitude, interval,
+                     vectorized, float32, time, compact, fast,
+                     [model](long) { return model; });
+}
+
+//' Fit the Ineichen-Perez clear sky model.
+//'
+//' @inheritParams zenith
+//' @param elevation Elevation of the location, in meters.
+//' @param a,b,c Model parameters.
+//' @param time Optional times to fit the model at, either POSIXct or seconds
+//' since 1970-01-01 UTC, instead of every interval of dayofyear and year,
+//' which are then ignored. See \code{\link{zenith_times}}.
+//' @param compact If TRUE, return a compact series, fit a day at a time when
+//' read. See \code{\link{zenith}}.
+//' @param fast If TRUE, interpolate the time only terms of the zenith angle
+//' between hours. See \code{\link{zenith}}.
+//' @param TL Linke turbidity. Either a single value, or one value for each
+//' element of dayofyear, or of time. With time, the value of the first time
+//' of each day is used for the whole day.
+//'
+//' @return Vector of fitted irradiance values for the given time period.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+SEXP ineichen_model(Rcpp::NumericVector dayofyear, Rcpp::NumericVector year,
+                    double tz, double latitude, double longitude,
+                    double interval, double elevation, double a,
+                    double b, double c, Rcpp::NumericVector TL,
+                    bool vectorized = false, bool float32 = false,
+                    SEXP time = R_NilValue, bool compact = false,
+                    bool fast = false) {
+    if (Rf_isNull(time) && TL.size() != 1 && TL.size() != dayofyear.size())
+        throw std::range_error("TL must have length 1 or the same length as dayofyear");
+    if (!Rf_isNull(time) && TL.size() != 1 && TL.size() != Rf_length(time))
+        throw std::range_error("TL must have length 1 or the same length as time");
+
+    bool constant = TL.size() == 1;
+    return fit_model(dayofyear, year, tz, latitude, longitude, interval,
+                     vectorized, float32, time, compact, fast, [=](long d) {
+                         return IneichenModel(a, b, c, TL[constant ? 0 : d], elevation);
+                     });
+}
+
+// GHI of model at each zenith angle of z, written to g, as fit_run.
+template <typename Model>
+void model_values(const Model &model, Rcpp::NumericVector z, double io,
+                  bool vectorized, Rcpp::NumericVector &g) {
+    std::copy(z.begin(), z.end(), g.begin());
+    if (vectorized) {
+        model_vectorized(model, io, g.begin(), g.size());
+        return;
+    }
+    for (long t = 0; t < g.size(); ++t) {
+        g[t] = model(g[t], io);
+    }
+}
+
+//' Apply a clear sky model to zenith angles.
+//'
+//' @param zenith Zenith angles, in degrees, from 0 to 90.
+//' @param io Extraterrestrial irradiance, see \code{\link{exrad}}.
+//' @param model One of 'ABCG', 'RS' or 'Ineichen'.
+//' @param a,b,c,TL,elevation Model parameters, as \code{\link{abcg_model}},
+//' \code{\link{rs_model}} and \code{\link{ineichen_model}}. Only those of
+//' the model are used.
+//' @param vectorized If TRUE, calculate the model with the vectorized
+//' approximations of clear_sky(vectorized = TRUE).
+//'
+//' @return Vector of irradiance values, one for each zenith angle.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::NumericVector model_ghi(Rcpp::NumericVector zenith, double io,
+                              std::string model, double a, double b, double c = 0,
+                              double TL = 0, double elevation = 0,
+                              bool vectorized = false) {
+    Rcpp::NumericVector g(zenith.size());
+    if (model == "ABCG") {
+        ABCGModel abcg = {a, b};
+        model_values(abcg, zenith, io, vectorized, g);
+    } else if (model == "RS") {
+        RSModel rs = {a, b, c};
+        model_values(rs, zenith, io, vectorized, g);
+    } else if (model == "Ineichen") {
+        model_values(IneichenModel(a, b, c, TL, elevation), zenith, io, vectorized, g);
+    } else {
+        throw std::range_error("model must be one of ABCG, RS or Ineichen");
+    }
+    return g;
+}
@@ -0,0 +1,81 @@
+#ifndef CLEARSKIES_MODELS_H
+#define CLEARSKIES_MODELS_H
+
+#include <math.h>      // cos(double), exp(double), pow(double, double)
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Clear sky models, independent of the R API.
+//
+// Each model is a functor of the zenith angle z, in degrees, and the
+// extraterrestrial irradiance io, returning GHI. Operations are ordered as in
+// the original R implementations, so results are identical.
+//
+// ghi<Math> is the same calculation with the elementary functions of Math,
+// either LibmMath, as the functor, or the vecmath approximations of
+// model_vectorized.
+
+struct LibmMath {
+    static double cos(double x) { return ::cos(x); }
+    static double exp(double x) { return ::exp(x); }
+    static double pow(double x, double y) { return ::pow(x, y); }
+};
+
+// Adnot-Bourges-Campana-Gicquel
+struct ABCGModel {
+    double a, b;
+
+    template <typename Math>
+    double ghi(double z, double) const {
+        return a * Math::pow(Math::cos(z * M_PI / 180), b);
+    }
+
+    double operator()(double z, double io) const { return ghi<LibmMath>(z, io); }
+};
+
+// Robledo-Soler
+struct RSModel {
+    double a, b, c;
+
+    template <typename Math>
+    double ghi(double z, double) const {
+        return a * Math::pow(Math::cos(z * M_PI / 180), b) * Math::exp(c * (90 - z));
+    }
+
+    double operator()(double z, double io) const { return ghi<LibmMath>(z, io); }
+};
+
+// Ineichen-Perez, at a fixed elevation and Linke turbidity.
+struct IneichenModel {
+    double a, b, c, TL;
+    double fh1, fh2;    // elevation correction factors
+    double cg1, cg2;
+
+    IneichenModel(double a, double b, double c, double TL, double elevation)
+        : a(a), b(b), c(c), TL(TL),
+          fh1(exp(-elevation / 8000)), fh2(exp(-elevation / 1250)),
+          cg1(0.0000509 * elevation + 0.868), cg2(0.0000392 * elevation + 0.0387) {}
+
+    template <typename Math>
+    double ghi(double z, double io) const {
+        double cz = Math::cos(z * M_PI / 180);
+        double AM = Math::pow(cz + a * Math::pow(90 + b - z, -c), -1);
+        return cg1 * io * cz * Math::exp(-cg2 * AM * (fh1 + fh2 * (TL - 1))) *
+               Math::exp(0.01 * Math::pow(AM, 1.8));
+    }
+
+    double operator()(double z, double io) const { return ghi<LibmMath>(z, io); }
+};
+
+// GHI of model for the n zenith angles at g, replaced in place, calculated
+// with the vecmath approximations of cos, exp and pow. For zenith angles of
+// 0 to 90 degrees and the default parameters of the models, and others
+// around them, GHI differs from the functor by less than 1e-11 W/m^2, and by
+// less than 1e-13 relative below 89.99 degrees. Defined in models_vec.cpp.
+void model_vectorized(const ABCGModel &model, double io, double *g, long n);
+void model_vectorized(const RSModel &model, double io, double *g, long n);
+void model_vectorized(const IneichenModel &model, double io, double *g, long n);
+
+#endif
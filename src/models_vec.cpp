@@ -0,0 +1,37 @@
+#include "models.h"
+#include "vecmath.h"
+
+// The elementary functions of the models, branch free so that the loops
+// below vectorize. pow is only approximated for positive x, which is every
+// base of the models at zenith angles of at most 90 degrees, and is 0 or
+// infinite at 0, and NaN below, as libm for non-integral y.
+struct VecMath {
+    static double cos(double x) { return vm_cos(x); }
+    static double exp(double x) { return vm_exp(x); }
+    static double pow(double x, double y) {
+        double p = vm_pow(x > 0 ? x : 1, y);
+        double at_zero = y > 0 ? 0 : (y == 0 ? 1 : HUGE_VAL);
+        return x > 0 ? p : (x == 0 ? at_zero : NAN);
+    }
+};
+
+CLEARSKIES_TARGET_CLONES
+void model_vectorized(const ABCGModel &model, double io, double *g, long n) {
+    for (long t = 0; t < n; ++t) {
+        g[t] = model.ghi<VecMath>(g[t], io);
+    }
+}
+
+CLEARSKIES_TARGET_CLONES
+void model_vectorized(const RSModel &model, double io, double *g, long n) {
+    for (long t = 0; t < n; ++t) {
+        g[t] = model.ghi<VecMath>(g[t], io);
+    }
+}
+
+CLEARSKIES_TARGET_CLONES
+void model_vectorized(const IneichenModel &model, double io, double *g, long n) {
+    for (long t = 0; t < n; ++t) {
+        g[t] = model.ghi<VecMath>(g[t], io);
+    }
+}
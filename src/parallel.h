@@ -0,0 +1,63 @@
+#ifndef CLEARSKIES_PARALLEL_H
+#define CLEARSKIES_PARALLEL_H
+
+#include <atomic>
+#include <chrono>      // milliseconds
+#include <condition_variable>
+#include <exception>   // exception_ptr
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <Rcpp.h>
+
+// Run work(t, cancel) for each task t in [0, n_tasks), each on its own
+// thread, and wait for all of them to finish.
+//
+// Worker threads can't use the R API, so user interrupts are checked here
+// while waiting. On an interrupt, or if any task throws, cancel is set, which
+// work should check regularly and return early when true. An exception
+// thrown by a task is rethrown once every thread has finished.
+template <typename Work>
+void run_parallel(int n_tasks, Work work) {
+    std::atomic<bool> cancel(false);
+    std::atomic<int> running(n_tasks);
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable done;
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < n_tasks; ++t) {
+        workers.emplace_back([&, t]() {
+            try {
+                work(t, cancel);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                error = std::current_exception();
+                cancel = true;
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            --running;
+            done.notify_one();
+        });
+    }
+
+    try {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (running > 0) {
+            done.wait_for(lock, std::chrono::milliseconds(100));
+            lock.unlock();
+            Rcpp::checkUserInterrupt();
+            lock.lock();
+        }
+    } catch (...) {
+        cancel = true;
+        for (auto &w : workers) w.join();
+        throw;
+    }
+
+    for (auto &w : workers) w.join();
+    if (error) std::rethrow_exception(error);
+}
+
+#endif
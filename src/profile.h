@@ -0,0 +1,47 @@
+#ifndef CLEARSKIES_PROFILE_H
+#define CLEARSKIES_PROFILE_H
+
+#include <chrono>
+#include <string>
+#include <utility>     // pair
+#include <vector>
+#include <Rcpp.h>
+
+// Wall clock times of the consecutive stages of an export, returned in the
+// profile attribute of clear_pts and zenith. Stages are only ended when
+// profiling, so otherwise the clock is read just once, on construction.
+class StageTimes {
+public:
+    StageTimes() : start_(Clock::now()) {}
+
+    // End the current stage, which started when the previous stage ended.
+    void end(const char *stage) {
+        Clock::time_point now = Clock::now();
+        stages_.push_back(std::make_pair(std::string(stage), seconds(start_, now)));
+        start_ = now;
+    }
+
+    // Seconds of each stage, named by stage.
+    Rcpp::NumericVector result() const {
+        Rcpp::NumericVector times(stages_.size());
+        Rcpp::CharacterVector names(stages_.size());
+        for (size_t i = 0; i < stages_.size(); ++i) {
+            names[i] = stages_[i].first;
+            times[i] = stages_[i].second;
+        }
+        times.attr("names") = names;
+        return times;
+    }
+
+    typedef std::chrono::steady_clock Clock;
+
+    static double seconds(Clock::time_point from, Clock::time_point to) {
+        return std::chrono::duration<double>(to - from).count();
+    }
+
+private:
+    Clock::time_point start_;
+    std::vector< std::pair<std::string, double> > stages_;
+};
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef CLEARSKIES_RESCALE_H
+#define CLEARSKIES_RESCALE_H
+
+#include <deque>
+#include <math.h>      // fabs
+#include <utility>     // pair
+#include <vector>
+#include "criterion.h"
+#include "detect.h"
+#include "window.h"
+
+// Iterative clear sky detection, as in Reno et al: detect the clear points,
+// rescale cs to fit x over them, and repeat until the clear points settle.
+// Independent of the R API.
+//
+// Most of each window's criterion don't need recalculating after cs is
+// scaled by a factor a: the mean and max terms of cs scale with a, sigma
+// doesn't change, and nothing of x does. Only the line length of cs and the
+// deviation from its slope are recalculated, from slopes of x and cs found
+// once.
+
+// Clear sky detection of series x and cs, for any number of scales of cs.
+// Keeps six values and a flag per window, and two slopes per point.
+class ScaledDetection {
+public:
+    ScaledDetection(const double *x, const double *cs, long n, int window_len,
+                    const Thresholds &thresholds)
+        : n_(n), window_len_(window_len), thresholds_(thresholds),
+          n_windows_(n - window_len + 1),
+          terms_(n_windows_ * N_SCALABLE_TERMS), valid_(n_windows_),
+          slope_x_(n), slope_cs_(n) {
+        // gaps are handled as in window_criteria
+        RollingWindow window(window_len);
+        for (long end = 0; end < n; ++end) {
+            if (is_gap(x, cs, end)) {
+                window.reset(end + 1);
+            } else {
+                window.push(x[end], cs[end]);
+            }
+
+            long i = end - window_len + 1;
+            if (i < 0) continue;
+            valid_[i] = window.full();
+            if (valid_[i]) window.scalable_terms(&terms_[i * N_SCALABLE_TERMS]);
+        }
+
+        for (long k = 1; k < n; ++k) {
+            slope_x_[k] = x[k] - x[k - 1];
+            slope_cs_[k] = cs[k] - cs[k - 1];
+        }
+    }
+
+    // Flag, in clear, every point covered by a window that is clear with cs
+    // scaled by a, which must be positive. clear must have room for n flags.
+    void detect(double a, unsigned char *clear) const {
+        double length = 0;
+        std::deque< std::pair<long, double> > deviation;
+        long covered = -1;
+
+        // slope k is between points k - 1 and k, and window i has slopes
+        // i + 1 to i + window_len - 1
+        for (long end = 0; end < n_; ++end) {
+            long i = end - window_len_ + 1;
+
+            if (end > 0 && window_len_ > 1) {
+                double d = a * slope_cs_[end];
+                double dev = fabs(slope_x_[end] - d);
+                length += segment_length(d);
+                if (dev == dev) {
+                    while (!deviation.empty() && deviation.back().second <= dev) {
+                        deviation.pop_back();
+                    }
+                    deviation.push_back(std::make_pair(end, dev));
+                }
+            }
+            if (i < 0) continue;
+            if (i > 0 && window_len_ > 1) {
+                length -= segment_length(a * slope_cs_[i]);
+            }
+            while (!deviation.empty() && deviation.front().first <= i) {
+                deviation.pop_front();
+            }
+
+            if (valid_[i]) {
+                // recalculate the line length regularly, and after any gap
+                if (i % window_len_ == 0 || length != length) {
+                    length = 0;
+                    for (long k = i + 1; k <= end; ++k) {
+                        length += segment_length(a * slope_cs_[k]);
+                    }
+                }
+
+                const double *t = &terms_[i * N_SCALABLE_TERMS];
+                double criterion[N_CRITERION];
+                criterion[0] = t[MEAN_X] - a * t[MEAN_CS];
+                criterion[1] = t[MAX_X] - a * t[MAX_CS];
+                criterion[2] = t[LENGTH_X] - length;
+                criterion[3] = t[SIGMA];
+                criterion[4] = deviation.empty() ? 0.0 : deviation.front().second;
+                if (within_thresholds(criterion, thresholds_)) {
+                    covered = end;
+                }
+            }
+
+            clear[i] = i <= covered;
+        }
+
+        for (long i = n_windows_; i < n_; ++i) {
+            clear[i] = i <= covered;
+        }
+    }
+
+private:
+    long n_;
+    int window_len_;
+    Thresholds thresholds_;
+    long n_windows_;
+    std::vector<double> terms_;         // N_SCALABLE_TERMS per window
+    std::vector<unsigned char> valid_;  // windows without a gap
+    std::vector<double> slope_x_, slope_cs_;
+};
+
+// Outcome of rescaled_detection.
+struct Rescaling {
+    std::vector<double> scales;     // scale of cs used by each iteration
+    double scale;                   // final scale of cs
+    bool converged;
+};
+
+// Scale of cs minimising the squared error with x over the clear points, or
+// 0 if there are none.
+inline double fit_scale(const double *x, const double *cs, long n,
+                        const unsigned char *clear) {
+    double xy = 0, yy = 0;
+    for (long i = 0; i < n; ++i) {
+        if (clear[i]) {
+            xy += x[i] * cs[i];
+            yy += cs[i] * cs[i];
+        }
+    }
+    return yy > 0 ? xy / yy : 0;
+}
+
+// Detect clear points with cs scaled by 1, then repeatedly by the scale
+// fitting x over the last clear points, for at most max_iter iterations.
+// Converged once the clear points don't change, or the scale changes by at
+// most tolerance relative to the last. Stops early, not converged, if there
+// are no clear points. stop is called before each iteration, as in
+// detect_clear.
+template <typename Stop>
+Rescaling rescaled_detection(const double *x, const double *cs, long n,
+                             int window_len, const Thresholds &thresholds,
+                             int max_iter, double tolerance, Stop stop) {
+    ScaledDetection detection(x, cs, n, window_len, thresholds);
+    std::vector<unsigned char> clear(n), last;
+
+    Rescaling result;
+    result.scale = 1;
+    result.converged = false;
+
+    for (int iter = 0; iter < max_iter && !stop(); ++iter) {
+        result.scales.push_back(result.scale);
+        detection.detect(result.scale, clear.data());
+        if (clear == last) {
+            result.converged = true;
+            break;
+        }
+
+        double scale = fit_scale(x, cs, n, clear.data());
+        if (!(scale > 0)) break;
+
+        double change = fabs(scale - result.scale);
+        result.scale = scale;
+        if (change <= tolerance * scale) {
+            result.converged = true;
+            break;
+        }
+        last.swap(clear);
+        clear.resize(n);
+    }
+
+    return result;
+}
+
+#endif
@@ -0,0 +1,183 @@
+#ifndef CLEARSKIES_SOLAR_H
+#define CLEARSKIES_SOLAR_H
+
+#include <math.h>      // floor(double), sin(double), cos(double), asin, acos, atan2
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Scalar solar position calculations, independent of the R API.
+//
+// The calculation is split into terms that depend only on time, and the
+// terms that depend on the location. Operations are ordered exactly as in the
+// original vectorized implementation, so results are identical.
+
+const double DEG2RAD = M_PI/180;
+const double RAD2DEG = 180/M_PI;
+
+// Reduce a to [0, c).
+inline double setnum(double a, double c) {
+    a = a - c * floor(a/c);
+    if (a < 0) {
+        return a + c;
+    } else {
+        return a;
+    }
+}
+
+// Extraterrestrial irradiance, W/m^2, on the given day of year: the solar
+// constant scaled by the earth radius vector.
+inline double extraterrestrial(double dayofyear) {
+    double dayangle = 360.0 * (dayofyear - 1.0) / 365.0;
+    double d2 = 2.0 * dayangle;
+
+    double erv = 1.00011 + (0.034221 * cos(DEG2RAD * dayangle)) + (0.00128 * sin(DEG2RAD * dayangle));
+    erv += 0.000719 * (cos(DEG2RAD * d2)) + (0.000077 * sin(DEG2RAD * d2));
+    return 1366.1 * erv;
+}
+
+// Solar position terms that depend only on time.
+struct SolarEphemeris {
+    double gmst;        // Greenwich mean sidereal time, hours
+    double rascen;      // right ascension, degrees
+    double sin_declin;  // sine of the declination
+    double cos_declin;  // cosine of the declination
+};
+
+// Location dependent terms.
+struct Location {
+    double sin_lat;
+    double cos_lat;
+    double longitude;
+
+    Location(double latitude, double longitude)
+        : sin_lat(sin(DEG2RAD * latitude)), cos_lat(cos(DEG2RAD * latitude)),
+          longitude(longitude) {}
+};
+
+// Time only terms at universal time utime (hours) on julian day julday.
+inline SolarEphemeris solar_ephemeris(double julday, double utime) {
+    SolarEphemeris eph;
+
+    // Time used in the calculation of ecliptic coordinates
+    double ecliptic_time = julday + utime / 24;
+    ecliptic_time = ecliptic_time - 51545;
+
+    // Mean longitude, all values between 0 and 360
+    double meanlong = setnum(280.46 + 0.9856474 * ecliptic_time, 360.0);
+
+    // Mean anomaly
+    double meananom = setnum(357.528 + 0.9856003 * ecliptic_time, 360.0);
+    meananom = meananom * DEG2RAD; // radians
+
+    // Ecliptic longitude
+    double eclipticlong = meanlong + 1.915 * sin(meananom) + 0.02 * sin(2*meananom);
+    eclipticlong = setnum(eclipticlong, 360.0);
+    eclipticlong = eclipticlong * DEG2RAD; // radians
+
+    // Obliquity of the ecliptic
+    double eclipticobli = 23.439 - 0.0000004 * ecliptic_time;
+    eclipticobli = eclipticobli * DEG2RAD; // radians
+
+    // Declination
+    // declin is only ever used in the context of deg2rad * declin
+    // but removing both rad2deg and deg2rad later causes (slight) numerical differences from R
+    // when calculating ETR solar zenith angle
+    // no idea why...
+    // but leave in (even though they should cancel out)
+    double declin = RAD2DEG * asin( sin(eclipticobli) * sin(eclipticlong) );
+    eph.sin_declin = sin(DEG2RAD * declin);
+    eph.cos_declin = cos(DEG2RAD * declin);
+
+    // Right ascension
+    double top = cos(eclipticobli) * sin(eclipticlong);
+    double bottom = cos(eclipticlong);
+    double rascen = RAD2DEG * atan2(top, bottom);
+
+    // ensure angle is positive
+    if (rascen < 0) {
+        rascen = rascen + 360.0;
+    }
+    eph.rascen = rascen;
+
+    // Greenwich mean sidereal time
+    eph.gmst = setnum(6.697375 + 0.0657098242 * ecliptic_time + utime, 24.0);
+
+    return eph;
+}
+
+// ETR solar zenith angle, in degrees, at location loc.
+inline double solar_zenith(const SolarEphemeris &eph, const Location &loc) {
+    // Local mean sidereal time
+    double lmst = setnum(eph.gmst * 15 + loc.longitude, 360.0);
+
+    // Hour angle, between -180 and 180 degrees
+    double hour_angle = lmst - eph.rascen;
+    if (hour_angle < -180) {
+        hour_angle = hour_angle + 360;
+    } else if (hour_angle > 180) {
+        hour_angle = hour_angle - 360;
+    }
+
+    double ch = cos(DEG2RAD * hour_angle);
+    double cz = eph.sin_declin * loc.sin_lat + eph.cos_declin * loc.cos_lat * ch;
+
+    // cos of zenith must be between -1 and 1
+    if (cz < -1) {
+        cz = -1;
+    } else if (cz > 1) {
+        cz = 1;
+    }
+
+    double zenetr = acos(cz) * RAD2DEG;
+
+    // limit the degrees below the horizon to 90
+    if (zenetr > 90) {
+        zenetr = 90;
+    }
+
+    return zenetr;
+}
+
+// Time only terms for every universal time on a set of julian days, in day
+// major order. Built once, and shared between any number of locations.
+struct EphemerisTable {
+    int n_times;        // universal times per day
+    std::vector<SolarEphemeris> terms;
+
+    EphemerisTable(const double *julday, int n_days, const double *utime,
+                   int n_times)
+        : n_times(n_times) {
+        terms.reserve((size_t) n_days * n_times);
+        for (int d = 0; d < n_days; ++d) {
+            for (int t = 0; t < n_times; ++t) {
+                terms.push_back(solar_ephemeris(julday[d], utime[t]));
+            }
+        }
+    }
+};
+
+// Zenith angles at loc for each of the n ephemeris terms, written to out.
+inline void solar_zenith(const SolarEphemeris *eph, long n, const Location &loc,
+                         double *out) {
+    for (long i = 0; i < n; ++i) {
+        out[i] = solar_zenith(eph[i], loc);
+    }
+}
+
+// As solar_zenith(solar_ephemeris(julday, utime[i]), loc) for each of n
+// universal times, written to out. Uses the vecmath approximations so that it
+// can be vectorized, see solar_vec.cpp.
+void solar_zenith_vectorized(double julday, const double *utime, int n,
+                             const Location &loc, double *out);
+
+// Approximately solar_zenith(solar_ephemeris(julday, utime[i]), loc) for each
+// of n universal times, written to out, interpolating the declination and
+// right ascension between whole hours. Differs from the exact angles by less
+// than 1e-9 degrees, see solar_fast.cpp.
+void solar_zenith_fast(double julday, const double *utime, int n,
+                       const Location &loc, double *out);
+
+#endif
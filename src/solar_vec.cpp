@@ -0,0 +1,48 @@
+#include "solar.h"
+#include "vecmath.h"
+
+// Zenith angles for n universal times on julian day julday, written to out.
+//
+// Follows solar_ephemeris and solar_zenith, but uses the vecmath
+// approximations so the loop can be vectorized. sin and cos of the
+// declination are computed directly rather than through asin.
+CLEARSKIES_TARGET_CLONES
+void solar_zenith_vectorized(double julday, const double *utime, int n,
+                             const Location &loc, double *out) {
+    for (int i = 0; i < n; ++i) {
+        double ecliptic_time = julday + utime[i] / 24 - 51545;
+
+        double meanlong = setnum(280.46 + 0.9856474 * ecliptic_time, 360.0);
+        double meananom = setnum(357.528 + 0.9856003 * ecliptic_time, 360.0) * DEG2RAD;
+
+        double sin_ma, cos_ma;
+        vm_sincos(meananom, &sin_ma, &cos_ma);
+
+        // sin(2a) = 2 sin(a) cos(a)
+        double eclipticlong = meanlong + 1.915 * sin_ma + 0.02 * (2 * sin_ma * cos_ma);
+        eclipticlong = setnum(eclipticlong, 360.0) * DEG2RAD;
+        double eclipticobli = (23.439 - 0.0000004 * ecliptic_time) * DEG2RAD;
+
+        double sin_el, cos_el, sin_eo, cos_eo;
+        vm_sincos(eclipticlong, &sin_el, &cos_el);
+        vm_sincos(eclipticobli, &sin_eo, &cos_eo);
+
+        // declination is within [-90, 90], so its cosine is non-negative
+        double sd = sin_eo * sin_el;
+        double cd = sqrt(1 - sd * sd);
+
+        double rascen = RAD2DEG * vm_atan2(cos_eo * sin_el, cos_el);
+        rascen = rascen < 0 ? rascen + 360.0 : rascen;
+
+        double gmst = setnum(6.697375 + 0.0657098242 * ecliptic_time + utime[i], 24.0);
+        double lmst = setnum(gmst * 15 + loc.longitude, 360.0);
+
+        // cos is periodic, so the hour angle doesn't need to be wrapped
+        double ch = vm_cos(DEG2RAD * (lmst - rascen));
+        double cz = sd * loc.sin_lat + cd * loc.cos_lat * ch;
+        cz = cz < -1 ? -1 : (cz > 1 ? 1 : cz);
+
+        double zenetr = vm_acos(cz) * RAD2DEG;
+        out[i] = zenetr > 90 ? 90 : zenetr;
+    }
+}
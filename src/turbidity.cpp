@@ -0,0 +1,218 @@
+#include <algorithm>   // min, max
+#include <fstream>
+#include <stdexcept>   // range_error, runtime_error
+#include <vector>
+#include <string.h>    // memcpy, memcmp
+#include <cmath>       // isfinite
+#include <math.h>      // floor(double), fmod, NAN
+#include <Rcpp.h>
+#include "turbidity.h"
+
+static_assert(sizeof(TurbidityHeader) == 24, "turbidity grid header must be 24 bytes");
+
+// Cumulative days before each month, and the following January, in a non
+// leap year.
+static const double MONTH_START[TURBIDITY_MONTHS + 1] = {
+    0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365
+};
+
+TurbidityGrid::TurbidityGrid(const std::string &path, bool bilinear, bool monthly)
+    : file_(path), bilinear_(bilinear), monthly_(monthly) {
+    TurbidityHeader header;
+    if (file_.size() < sizeof(header)) {
+        throw std::runtime_error(path + " is not a turbidity grid");
+    }
+    memcpy(&header, file_.data(), sizeof(header));
+
+    if (memcmp(header.magic, "CSLT", 4) != 0 || header.version != TURBIDITY_VERSION ||
+        header.n_months != TURBIDITY_MONTHS || header.n_lat == 0 || header.n_lon == 0) {
+        throw std::runtime_error(path + " is not a turbidity grid");
+    }
+
+    if (!std::isfinite(header.scale) || header.scale <= 0) {
+        throw std::runtime_error(path + " has an invalid scale");
+    }
+
+    n_lat_ = header.n_lat;
+    n_lon_ = header.n_lon;
+    scale_ = header.scale;
+    if (file_.size() != sizeof(header) + (size_t) n_lat_ * n_lon_ * TURBIDITY_MONTHS) {
+        throw std::runtime_error(path + " is truncated");
+    }
+    values_ = file_.data() + sizeof(header);
+}
+
+double TurbidityGrid::at(double latitude, double longitude, int month) const {
+    // position in cells, with cell centers at integral values. Latitude is
+    // clamped and longitude wrapped first, so that the cells of any finite
+    // location can be indexed
+    double lat = std::min(std::max(latitude, -90.0), 90.0);
+    double lon = fmod(longitude + 180, 360);
+    if (lon < 0) lon += 360;
+    double y = (90 - lat) * n_lat_ / 180 - 0.5;
+    double x = lon * n_lon_ / 360 - 0.5;
+
+    if (!bilinear_) {
+        long row = std::min(std::max((long) floor(y + 0.5), 0L), n_lat_ - 1);
+        long col = (long) floor(x + 0.5) % n_lon_;
+        return cell(row, col < 0 ? col + n_lon_ : col, month);
+    }
+
+    double r = floor(y), c = floor(x);
+    double wy = y - r, wx = x - c;
+
+    // latitude is clamped at the poles, longitude wraps around
+    long r0 = std::min(std::max((long) r, 0L), n_lat_ - 1);
+    long r1 = std::min(std::max((long) r + 1, 0L), n_lat_ - 1);
+    long c0 = (long) c % n_lon_;
+    if (c0 < 0) c0 += n_lon_;
+    long c1 = (c0 + 1) % n_lon_;
+
+    return (1 - wy) * ((1 - wx) * cell(r0, c0, month) + wx * cell(r0, c1, month)) +
+           wy * ((1 - wx) * cell(r1, c0, month) + wx * cell(r1, c1, month));
+}
+
+double TurbidityGrid::lookup(double latitude, double longitude, double dayofyear) const {
+    if (!std::isfinite(latitude) || !std::isfinite(longitude) || !std::isfinite(dayofyear)) {
+        return NAN;
+    }
+
+    // day 366 is treated as the end of December
+    double day = std::min(std::max(dayofyear - 0.5, 0.0), 364.999);
+
+    if (!monthly_) {
+        int month = 0;
+        while (day >= MONTH_START[month + 1]) ++month;
+        return at(latitude, longitude, month);
+    }
+
+    // find the months whose middles are either side of day, wrapping
+    // between December and January
+    int month = 0;
+    while (month < 12 && day >= (MONTH_START[month] + MONTH_START[month + 1]) / 2) ++month;
+    int before = (month + 11) % 12;
+    int after = month % 12;
+
+    double mid_before = (MONTH_START[before] + MONTH_START[before + 1]) / 2;
+    double mid_after = (MONTH_START[after] + MONTH_START[after + 1]) / 2;
+    if (mid_before > day) mid_before -= 365;
+    if (mid_after < day) mid_after += 365;
+
+    double w = (day - mid_before) / (mid_after - mid_before);
+    return (1 - w) * at(latitude, longitude, before) + w * at(latitude, longitude, after);
+}
+
+//' Open a Linke turbidity grid.
+//'
+//' The grid file is memory mapped, so only the parts of it used for lookups
+//' are ever read from disk.
+//'
+//' @param path Path of a grid file written by
+//' \code{\link{write_turbidity_grid}}.
+//' @param bilinear If TRUE, interpolate between the four nearest cells rather
+//' than use the value of the cell containing the location.
+//' @param monthly If TRUE, interpolate between the middle of adjacent months
+//' rather than use the value of the month containing the day.
+//'
+//' @return An external pointer of class 'turbidity_grid', which may be passed
+//' as the TL parameter of the Ineichen model. The pointer is not valid after
+//' being saved and reloaded.
+//'
+//' @examples
+//' # 2 x 4 grid of 90 degree cells, the same turbidity all year
+//' path = tempfile()
+//' write_turbidity_grid(array(c(2, 3), c(2, 4, 12)), path)
+//' grid = turbidity_grid(path, bilinear = TRUE)
+//' linke_turbidity(grid, 44.05, -123.07, c(1, 182))
+//' Ineichen(1, 2014, -8, 44.05, -123.07, 1, 150,
+//'          parameters = list(a = 0.50572, b = 6.07995, c = 1.6364, TL = grid))
+//'
+//' @export
+// [[Rcpp::export]]
+Rcpp::XPtr<TurbidityGrid> turbidity_grid(std::string path, bool bilinear = false,
+                                         bool monthly = false) {
+    Rcpp::XPtr<TurbidityGrid> grid(new TurbidityGrid(path, bilinear, monthly));
+    grid.attr("class") = "turbidity_grid";
+    return grid;
+}
+
+//' Look up the Linke turbidity in a grid.
+//'
+//' @param grid Grid opened by \code{\link{turbidity_grid}}.
+//' @param latitude Latitude of the location.
+//' @param longitude Longitude of the location.
+//' @param dayofyear Numeric vector of days of year.
+//'
+//' @return Linke turbidity at the location on each day of year, NA where the
+//' location or day of year isn't finite.
+//'
+//' @export
+// [[Rcpp::export]]
+Rcpp::NumericVector linke_turbidity(Rcpp::XPtr<TurbidityGrid> grid, double latitude,
+                                    double longitude, Rcpp::NumericVector dayofyear) {
+    if (!grid.inherits("turbidity_grid")) {
+        throw std::range_error("grid must be created by turbidity_grid()");
+    }
+    if (grid.get() == NULL) {
+        throw std::range_error("grid is no longer valid, it must be reopened");
+    }
+
+    Rcpp::NumericVector tl(dayofyear.size());
+    for (int i = 0; i < dayofyear.size(); ++i) {
+        double value = grid->lookup(latitude, longitude, dayofyear[i]);
+        tl[i] = ISNAN(value) ? NA_REAL : value;
+    }
+    return tl;
+}
+
+//' Write a Linke turbidity grid file.
+//'
+//' @param values Numeric array of Linke turbidity, with dimensions latitude
+//' (from 90 to -90 degrees), longitude (from -180 to 180 degrees) and month.
+//' @param path Path of the file to write.
+//' @param scale Resolution of the stored values. Values are rounded to the
+//' nearest multiple of scale, which must be from 0 to 255 times scale.
+//'
+//' @export
+// [[Rcpp::export]]
+void write_turbidity_grid(Rcpp::NumericVector values, std::string path,
+                          double scale = 0.05) {
+    if (!values.hasAttribute("dim"))
+        throw std::range_error("values must be an array");
+    Rcpp::IntegerVector dim = values.attr("dim");
+    if (dim.size() != 3 || dim[2] != (int) TURBIDITY_MONTHS)
+        throw std::range_error("values must have dimensions latitude, longitude and 12 months");
+    if (!std::isfinite(scale) || scale <= 0 || (float) scale <= 0)
+        throw std::range_error("scale must be positive");
+
+    TurbidityHeader header;
+    memcpy(header.magic, "CSLT", 4);
+    header.version = TURBIDITY_VERSION;
+    header.n_lat = dim[0];
+    header.n_lon = dim[1];
+    header.n_months = TURBIDITY_MONTHS;
+    header.scale = (float) scale;
+
+    // reorder from R's column major array to the months of each cell adjacent
+    long n_lat = dim[0], n_lon = dim[1];
+    std::vector<unsigned char> cells(n_lat * n_lon * TURBIDITY_MONTHS);
+    for (long m = 0; m < (long) TURBIDITY_MONTHS; ++m) {
+        for (long j = 0; j < n_lon; ++j) {
+            for (long i = 0; i < n_lat; ++i) {
+                double v = values[i + n_lat * (j + n_lon * m)];
+                if (ISNAN(v))
+                    throw std::range_error("values must not be NA");
+                double units = floor(v / header.scale + 0.5);
+                if (!(units >= 0 && units <= 255))
+                    throw std::range_error("values must be from 0 to 255 times scale");
+                cells[(i * n_lon + j) * TURBIDITY_MONTHS + m] = (unsigned char) units;
+            }
+        }
+    }
+
+    std::ofstream out(path.c_str(), std::ios::binary);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(cells.data()), cells.size());
+    if (!out)
+        throw std::runtime_error("Unable to write " + path);
+}
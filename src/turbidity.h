@@ -0,0 +1,64 @@
+#ifndef CLEARSKIES_TURBIDITY_H
+#define CLEARSKIES_TURBIDITY_H
+
+#include <stdint.h>    // uint32_t
+#include <string>
+#include "mapped_file.h"
+
+// Monthly Linke turbidity on a global latitude/longitude grid, read from a
+// memory mapped file, independent of the R API.
+//
+// The file starts with a 24 byte header, in native (little endian) byte
+// order:
+//
+//     char[4]   magic       "CSLT"
+//     uint32    version     1
+//     uint32    n_lat       rows, from 90 to -90 degrees latitude
+//     uint32    n_lon       columns, from -180 to 180 degrees longitude
+//     uint32    n_months    12
+//     float32   scale       Linke turbidity of one stored unit
+//
+// followed by n_lat * n_lon * 12 unsigned bytes, with the cells in row major
+// order and the months of each cell adjacent. A 1/12 degree grid is 2160 by
+// 4320 cells, about 110MB.
+struct TurbidityHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t n_lat;
+    uint32_t n_lon;
+    uint32_t n_months;
+    float scale;
+};
+
+const uint32_t TURBIDITY_VERSION = 1;
+const uint32_t TURBIDITY_MONTHS = 12;
+
+class TurbidityGrid {
+public:
+    // Throws std::runtime_error if the file can't be read or isn't a grid.
+    // If bilinear, values are interpolated between the four nearest cell
+    // centers rather than taken from the enclosing cell. If monthly, values
+    // are interpolated between the middle of adjacent months.
+    TurbidityGrid(const std::string &path, bool bilinear, bool monthly);
+
+    // Linke turbidity at the given location on a day of year, 1 to 366.
+    // Latitudes beyond the poles are clamped to them. NaN unless every
+    // argument is finite.
+    double lookup(double latitude, double longitude, double dayofyear) const;
+
+private:
+    double cell(long row, long col, int month) const {
+        return scale_ * values_[(row * n_lon_ + col) * TURBIDITY_MONTHS + month];
+    }
+    double at(double latitude, double longitude, int month) const;
+
+    MappedFile file_;
+    long n_lat_;
+    long n_lon_;
+    double scale_;
+    const unsigned char *values_;
+    bool bilinear_;
+    bool monthly_;
+};
+
+#endif
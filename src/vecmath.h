@@ -0,0 +1,240 @@
+#ifndef CLEARSKIES_VECMATH_H
+#define CLEARSKIES_VECMATH_H
+
+#include <math.h>      // sqrt(double), fabs(double)
+#include <stdint.h>    // int64_t
+#include <string.h>    // memcpy
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Branch free polynomial approximations of the libm functions used by the
+// solar position and clear sky model kernels.
+//
+// libm calls can't be vectorized, so loops calling sin, cos etc. run one
+// value at a time. These functions are built only from arithmetic, sqrt and
+// selects, so loops using them can be vectorized by the compiler. Over the
+// argument ranges used by this package, the relative error of each
+// function is within a few ulp of the libm result:
+//
+//     vm_sin, vm_cos    |x| < 1e5         < 2e-16
+//     vm_acos           [-1, 1]           < 4e-16
+//     vm_atan2          all finite        < 3e-16
+//     vm_exp            [-708, 709]       < 3e-16
+//     vm_log            (0, DBL_MAX]      < 2e-16
+//
+// Special values (NaN, infinities) are not handled.
+
+// Translation units using these need to be compiled with -fno-math-errno and
+// -fno-trapping-math (see Makevars), otherwise sqrt and selects between
+// divisions stop loops from being vectorized. Neither changes results.
+//
+// Where the compiler supports it, CLEARSKIES_TARGET_CLONES compiles a
+// function once per instruction set, with the best version for the CPU
+// selected at load time. The default version uses baseline SSE2.
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && \
+    defined(__linux__) && (__GNUC__ >= 6)
+#define CLEARSKIES_TARGET_CLONES \
+    __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define CLEARSKIES_TARGET_CLONES
+#endif
+
+// Sine and cosine, reduced to [-pi/4, pi/4] about the nearest multiple of
+// pi/2. Coefficients from Cephes.
+inline void vm_sincos(double x, double *s, double *c) {
+    const double PIO2_1 = 1.57079632673412561417e+00;   // first 33 bits of pi/2
+    const double PIO2_1T = 6.07710050650619224932e-11;  // pi/2 - PIO2_1
+
+    double k = floor(x * (2 / M_PI) + 0.5);
+    double r = (x - k * PIO2_1) - k * PIO2_1T;
+    double z = r * r;
+
+    double ps = 1.58962301576546568060e-10;
+    ps = ps * z - 2.50507477628578072866e-8;
+    ps = ps * z + 2.75573136213857245213e-6;
+    ps = ps * z - 1.98412698295895385996e-4;
+    ps = ps * z + 8.33333333332211858878e-3;
+    ps = ps * z - 1.66666666666666307295e-1;
+    double sr = r + r * z * ps;
+
+    double pc = -1.13585365213876817300e-11;
+    pc = pc * z + 2.08757008419747316778e-9;
+    pc = pc * z - 2.75573141792967388112e-7;
+    pc = pc * z + 2.48015872888517045348e-5;
+    pc = pc * z - 1.38888888888730564116e-3;
+    pc = pc * z + 4.16666666666665929218e-2;
+    double cr = 1.0 - 0.5 * z + z * z * pc;
+
+    // quadrant of x, kept as a double since not every instruction set can
+    // convert vectors of doubles to 64 bit integers
+    double q = k - 4 * floor(k * 0.25);
+    bool odd = q == 1 || q == 3;
+    double sv = odd ? cr : sr;
+    double cv = odd ? sr : cr;
+    *s = q >= 2 ? -sv : sv;
+    *c = q == 1 || q == 2 ? -cv : cv;
+}
+
+inline double vm_sin(double x) {
+    double s, c;
+    vm_sincos(x, &s, &c);
+    return s;
+}
+
+inline double vm_cos(double x) {
+    double s, c;
+    vm_sincos(x, &s, &c);
+    return c;
+}
+
+// asin(x) = x + x * vm_asin_r(x^2), for |x| < 0.5. Coefficients from fdlibm.
+inline double vm_asin_r(double z) {
+    double p = 3.47933107596021167570e-05;
+    p = p * z + 7.91534994289814532176e-04;
+    p = p * z - 4.00555345006794114027e-02;
+    p = p * z + 2.01212532134862925881e-01;
+    p = p * z - 3.25565818622400915405e-01;
+    p = p * z + 1.66666666666666657415e-01;
+
+    double q = 7.70381505559019352791e-02;
+    q = q * z - 6.88283971605453293030e-01;
+    q = q * z + 2.02094576023350569471e+00;
+    q = q * z - 2.40339491173441421878e+00;
+    q = q * z + 1.0;
+
+    return z * p / q;
+}
+
+// Arc cosine, for x in [-1, 1].
+inline double vm_acos(double x) {
+    double a = fabs(x);
+    bool small = a < 0.5;
+
+    // acos(x) = 2 asin(sqrt((1 - |x|) / 2)), reflected for negative x
+    double z = small ? x * x : (1 - a) * 0.5;
+    double s = sqrt(z);
+    double r = vm_asin_r(z);
+
+    double w = 2 * (s + s * r);
+    double big = x > 0 ? w : M_PI - w;
+    return small ? M_PI / 2 - (x + x * r) : big;
+}
+
+// Arc tangent of y/x, using the signs of both to find the quadrant.
+// Coefficients from Cephes.
+inline double vm_atan2(double y, double x) {
+    double ax = fabs(x), ay = fabs(y);
+    double hi = ax > ay ? ax : ay;
+    double lo = ax > ay ? ay : ax;
+    // divisions are unconditional, with the operands selected beforehand, so
+    // that the function doesn't branch
+    double t = lo / (hi > 0 ? hi : 1.0);    // in [0, 1]
+
+    // reduce to |t| <= tan(pi/8) using atan(t) = pi/4 + atan((t-1)/(t+1))
+    bool reduce = t > 0.41421356237309504880;
+    double u = (reduce ? t - 1 : t) / (reduce ? t + 1 : 1.0);
+    double z = u * u;
+
+    double p = -8.750608600031904122785e-1;
+    p = p * z - 1.615753718733365076637e1;
+    p = p * z - 7.500855792314704667340e1;
+    p = p * z - 1.228866684490136173410e2;
+    p = p * z - 6.485021904942025371773e1;
+
+    double q = z + 2.485846490142306297962e1;
+    q = q * z + 1.650270098316988542046e2;
+    q = q * z + 4.328810604912902668951e2;
+    q = q * z + 4.853903996359136964868e2;
+    q = q * z + 1.945506571482613964425e2;
+
+    double r = u + u * z * p / q;
+    r = reduce ? r + M_PI / 4 : r;
+
+    r = ay > ax ? M_PI / 2 - r : r;
+    r = x < 0 ? M_PI - r : r;
+    return y < 0 ? -r : r;
+}
+
+// 2^52, adding it to a double in [0, 2^52) leaves the integral part in the
+// low bits of the mantissa
+const double VM_MAGIC = 4503599627370496.0;
+
+// 2^k for integral k in [-1022, 1023].
+inline double vm_pow2i(double k) {
+    double biased = k + (1023 + VM_MAGIC);
+    int64_t bits;
+    memcpy(&bits, &biased, sizeof(bits));
+    bits <<= 52;
+
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+// Exponential, for x in [-708, 709].
+inline double vm_exp(double x) {
+    const double LN2_HI = 6.93147180369123816490e-01;
+    const double LN2_LO = 1.90821492927058770002e-10;
+
+    x = x < -708 ? -708 : (x > 709 ? 709 : x);
+    double k = floor(x * 1.44269504088896338700 + 0.5);
+    double r = (x - k * LN2_HI) - k * LN2_LO;   // |r| <= ln(2)/2
+
+    // Taylor series, truncation error below 1e-17 for |r| <= ln(2)/2
+    double p = 1.0 / 479001600;
+    p = p * r + 1.0 / 39916800;
+    p = p * r + 1.0 / 3628800;
+    p = p * r + 1.0 / 362880;
+    p = p * r + 1.0 / 40320;
+    p = p * r + 1.0 / 5040;
+    p = p * r + 1.0 / 720;
+    p = p * r + 1.0 / 120;
+    p = p * r + 1.0 / 24;
+    p = p * r + 1.0 / 6;
+    p = p * r + 0.5;
+    p = p * r * r + r + 1.0;
+
+    return p * vm_pow2i(k);
+}
+
+// Natural logarithm, for positive normal x. Coefficients from fdlibm.
+inline double vm_log(double x) {
+    const double LN2_HI = 6.93147180369123816490e-01;
+    const double LN2_LO = 1.90821492927058770002e-10;
+
+    // split x into m * 2^e, with m in [sqrt(2)/2, sqrt(2))
+    int64_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    int64_t ebits = ((bits >> 52) & 0x7ff) | 0x4330000000000000LL;
+    int64_t mbits = (bits & 0x000fffffffffffffLL) | 0x3ff0000000000000LL;
+    double e, m;
+    memcpy(&e, &ebits, sizeof(e));
+    memcpy(&m, &mbits, sizeof(m));
+    e = e - (VM_MAGIC + 1023);
+
+    bool high = m > 1.41421356237309504880;
+    m = high ? m * 0.5 : m;
+    double k = e + (high ? 1.0 : 0.0);
+
+    double f = m - 1;
+    double s = f / (2 + f);
+    double z = s * s;
+    double w = z * z;
+    double t1 = w * (3.999999999940941908e-01 + w * (2.222219843214978396e-01 +
+                w * 1.531383769920937332e-01));
+    double t2 = z * (6.666666666666735130e-01 + w * (2.857142874366239149e-01 +
+                w * (1.818357216161805012e-01 + w * 1.479819860511658591e-01)));
+    double r = t1 + t2;
+    double hfsq = 0.5 * f * f;
+
+    return k * LN2_HI - ((hfsq - (s * (hfsq + r) + k * LN2_LO)) - f);
+}
+
+// x^y for positive x.
+inline double vm_pow(double x, double y) {
+    return vm_exp(y * vm_log(x));
+}
+
+#endif
@@ -0,0 +1,171 @@
+#include <cmath>       // fabs
+#include "criterion.h"
+#include "window.h"
+
+
+RollingWindow::RollingWindow(int window_len, long index)
+    : window_len_(window_len), obs_(window_len), pred_(window_len) {
+    reset(index);
+}
+
+void RollingWindow::reset(long index) {
+    count_ = 0;
+    base_ = index;
+    sum_x_ = sum_cs_ = 0.0;
+    len_x_ = len_cs_ = 0.0;
+    ssq_x_ = ssq_cs_ = 0.0;
+    zeros_x_ = zeros_cs_ = 0;
+    max_x_.clear();
+    max_cs_.clear();
+    max_dev_.clear();
+}
+
+void RollingWindow::enqueue(MaxQueue &q, long index, double value) {
+    // values that can never be the max again are dropped
+    while (!q.empty() && q.back().second <= value) {
+        q.pop_back();
+    }
+    q.push_back(std::make_pair(index, value));
+}
+
+void RollingWindow::expire(MaxQueue &q, long first) {
+    while (!q.empty() && q.front().first < first) {
+        q.pop_front();
+    }
+}
+
+void RollingWindow::push(double x, double cs) {
+    long k = count_;
+    int pos = k % window_len_;
+
+    // slope k, between samples k - 1 and k, enters the window.
+    // windows of length 1 have no slopes
+    if (window_len_ > 1 && k > 0) {
+        int prev = (k - 1) % window_len_;
+        double s = x - obs_[prev];
+        double d = cs - pred_[prev];
+
+        len_x_ += segment_length(s);
+        len_cs_ += segment_length(d);
+        ssq_x_ += s*s;
+        ssq_cs_ += d*d;
+        enqueue(max_dev_, k, std::fabs(s - d));
+    }
+
+    // sample k - window_len, and the slope following it, leave the window.
+    // the sample is overwritten in the ring buffer below
+    if (k >= window_len_) {
+        double old_x = obs_[pos];
+        double old_cs = pred_[pos];
+        sum_x_ -= old_x;
+        sum_cs_ -= old_cs;
+        zeros_x_ -= old_x == 0;
+        zeros_cs_ -= old_cs == 0;
+
+        if (window_len_ > 1) {
+            int next = (pos + 1) % window_len_;
+            double s = obs_[next] - old_x;
+            double d = pred_[next] - old_cs;
+
+            len_x_ -= segment_length(s);
+            len_cs_ -= segment_length(d);
+            ssq_x_ -= s*s;
+            ssq_cs_ -= d*d;
+        }
+    }
+
+    obs_[pos] = x;
+    pred_[pos] = cs;
+    sum_x_ += x;
+    sum_cs_ += cs;
+    zeros_x_ += x == 0;
+    zeros_cs_ += cs == 0;
+    enqueue(max_x_, k, x);
+    enqueue(max_cs_, k, cs);
+
+    ++count_;
+
+    long first = count_ - window_len_;
+    expire(max_x_, first);
+    expire(max_cs_, first);
+    expire(max_dev_, first + 1);
+
+    if (full() && (base_ + count_) % window_len_ == 0) {
+        resync();
+    }
+
+    // a window of zeros has no slopes, and the line length of window_len - 1
+    // that resync would give
+    if (zeros_x_ == window_len_) {
+        sum_x_ = ssq_x_ = 0.0;
+        len_x_ = window_len_ - 1;
+    }
+    if (zeros_cs_ == window_len_) {
+        sum_cs_ = ssq_cs_ = 0.0;
+        len_cs_ = window_len_ - 1;
+    }
+}
+
+void RollingWindow::resync() {
+    // oldest sample is at the current write position
+    int start = count_ % window_len_;
+
+    sum_x_ = sum_cs_ = 0.0;
+    len_x_ = len_cs_ = 0.0;
+    ssq_x_ = ssq_cs_ = 0.0;
+
+    for (int i = 0; i < window_len_; ++i) {
+        int cur = (start + i) % window_len_;
+        sum_x_ += obs_[cur];
+        sum_cs_ += pred_[cur];
+
+        if (i > 0) {
+            int prev = (start + i - 1) % window_len_;
+            double s = obs_[cur] - obs_[prev];
+            double d = pred_[cur] - pred_[prev];
+
+            len_x_ += segment_length(s);
+            len_cs_ += segment_length(d);
+            ssq_x_ += s*s;
+            ssq_cs_ += d*d;
+        }
+    }
+}
+
+void RollingWindow::criterion(double *out) const {
+    for (int c = 0; c < N_CRITERION; ++c) {
+        out[c] = criterion(c);
+    }
+}
+
+double RollingWindow::criterion(int c) const {
+    switch (c) {
+    case 0:     // mean difference
+        return sum_x_ / window_len_ - sum_cs_ / window_len_;
+    case 1:     // max difference
+        return max_x_.front().second - max_cs_.front().second;
+    case 2:     // line length difference
+        return len_x_ - len_cs_;
+    case 3: {   // sigma difference
+        // sum of the slopes telescopes to the difference between the newest
+        // and oldest samples
+        int newest = (count_ - 1) % window_len_;
+        int oldest = count_ % window_len_;
+        double slopes_x = obs_[newest] - obs_[oldest];
+        double slopes_cs = pred_[newest] - pred_[oldest];
+        return slope_sigma(slopes_x, ssq_x_, window_len_ - 1, sum_x_ / window_len_) -
+               slope_sigma(slopes_cs, ssq_cs_, window_len_ - 1, sum_cs_ / window_len_);
+    }
+    default:    // max deviance, 0 for windows of 1 point as max_deviation
+        return max_dev_.empty() ? 0.0 : max_dev_.front().second;
+    }
+}
+
+void RollingWindow::scalable_terms(double *out) const {
+    out[MEAN_X] = sum_x_ / window_len_;
+    out[MEAN_CS] = sum_cs_ / window_len_;
+    out[MAX_X] = max_x_.front().second;
+    out[MAX_CS] = max_cs_.front().second;
+    out[LENGTH_X] = len_x_;
+    out[SIGMA] = criterion(3);
+}
@@ -0,0 +1,87 @@
+#ifndef CLEARSKIES_WINDOW_H
+#define CLEARSKIES_WINDOW_H
+
+#include <deque>     // deque
+#include <utility>   // pair
+#include <vector>
+
+// Criterion terms written by RollingWindow::scalable_terms.
+enum ScalableTerm {
+    MEAN_X, MEAN_CS,        // means
+    MAX_X, MAX_CS,          // maxima
+    LENGTH_X,               // line length of x
+    SIGMA,                  // sigma criterion, which doesn't depend on scale
+    N_SCALABLE_TERMS
+};
+
+// Incremental computation of the five clear sky criterion over a rolling
+// window.
+//
+// Samples are pushed one at a time. Once window_len samples have been pushed,
+// the criterion for the most recent window_len samples are available in
+// constant time: running sums are kept for the means, line lengths and
+// squared slopes, and monotonic deques are kept for the max terms.
+//
+// Running sums are recomputed from the window contents whenever the index
+// of the next sample in the series is a multiple of window_len, so that
+// rounding error doesn't accumulate over long series. Windows over the same
+// samples therefore give exactly the same criterion regardless of where in
+// the series the calculation started, as long as it started at a multiple of
+// window_len or after a reset. The sums of windows of exact zeros, such as
+// nights, are also set exactly, so that their mean and sigma are 0 as in the
+// recalculated criterion, rather than the rounding error left by the samples
+// that came before.
+class RollingWindow {
+public:
+    // index is the position in the series of the first sample to be pushed.
+    explicit RollingWindow(int window_len, long index = 0);
+
+    // Append a sample, dropping the oldest sample if the window is full.
+    void push(double x, double cs);
+
+    // Drop all samples. index is the position in the series of the next
+    // sample to be pushed.
+    void reset(long index = 0);
+
+    // True once window_len samples have been pushed.
+    bool full() const { return count_ >= window_len_; }
+
+    // Write the criterion of the current window to out, which must have
+    // room for five values. Ordered as in calculate_criterion.
+    void criterion(double *out) const;
+
+    // Criterion c of the current window alone, exactly as written by
+    // criterion(out), so that windows can be rejected without calculating
+    // every criterion.
+    double criterion(int c) const;
+
+    // Terms of the criterion that are either unchanged or scaled in
+    // proportion when cs is scaled by a positive factor, written to out in
+    // the order of ScalableTerm. See ScaledDetection.
+    void scalable_terms(double *out) const;
+
+private:
+    typedef std::deque< std::pair<long, double> > MaxQueue;
+
+    static void enqueue(MaxQueue &q, long index, double value);
+    static void expire(MaxQueue &q, long first);
+
+    void resync();
+
+    int window_len_;
+    long count_;
+    long base_;     // series index of the first sample pushed
+
+    // ring buffers of the last window_len samples
+    std::vector<double> obs_;
+    std::vector<double> pred_;
+
+    double sum_x_, sum_cs_;     // sample sums
+    double len_x_, len_cs_;     // line lengths
+    double ssq_x_, ssq_cs_;     // sums of squared slopes
+    int zeros_x_, zeros_cs_;    // samples that are exactly 0
+
+    MaxQueue max_x_, max_cs_, max_dev_;
+};
+
+#endif
@@ -1,8 +1,17 @@
-#include <algorithm>   // transform, copy
+#include <algorithm>   // fill, max, min
+#include <atomic>
+#include <map>
 #include <stdexcept>   // range_error
-#include <math.h>      // floor(double), sin(double), cos(double), atan2
-#include <numeric>     // iota
+#include <vector>
+#include <math.h>      // floor(double), fabs(double)
 #include <Rcpp.h>
+#include "altrep.h"
+#include "cache.h"
+#include "float32.h"
+#include "parallel.h"
+#include "profile.h"
+#include "solar.h"
+#include "zenith.h"
 // [[Rcpp::plugins(cpp11)]]
 
 
@@ -10,69 +19,166 @@ double calc_julian_day(double year, double dayofyear) {
     return 32916.5 + (year - 1949)*365 + (floor((year - 1949)/4)) + dayofyear;
 }
 
-Rcpp::NumericVector julian_day(Rcpp::NumericVector dayofyear, Rcpp::NumericVector year) {
+// Most recently used time grids and julian days. Grids of one second
+// intervals are 675 KiB, so at most 11 MiB are kept, and julian days are
+// usually far smaller.
+const size_t GRID_CACHE_SIZE = 16;
+const size_t JULIAN_CACHE_SIZE = 64;
+
+typedef std::pair<uint64_t, uint64_t> GridKey;
+static LruCache<GridKey, std::vector<double> > grid_cache(GRID_CACHE_SIZE);
+static LruCache<std::vector<uint64_t>, std::vector<double> > julian_cache(JULIAN_CACHE_SIZE);
+
+SharedTimes julian_day(const Rcpp::NumericVector &dayofyear, const Rcpp::NumericVector &year) {
     int n_days = dayofyear.size();
     int n_years = year.size();
 
-    // recycle shorter vector to length of longer vector
-    if (n_years > n_days) {
-        dayofyear = rep_len(dayofyear, n_years);
-    } else if (n_days > n_years) {
-        year = rep_len(year, n_days);
-    }
-
-    Rcpp::NumericVector ret(year.size());
+    // keyed by the values of both vectors, and the length of the first to
+    // tell where one ends
+    std::vector<uint64_t> key;
+    key.reserve(1 + n_days + n_years);
+    key.push_back(n_days);
+    for (double d : dayofyear) key.push_back(double_bits(d));
+    for (double y : year) key.push_back(double_bits(y));
+
+    return julian_cache.get(key, [&]() {
+        // recycle shorter vector to length of longer vector, unless empty
+        int n = n_days > 0 && n_years > 0 ? std::max(n_days, n_years) : 0;
+        std::vector<double> julday(n);
+        for (int i = 0; i < n; ++i) {
+            julday[i] = calc_julian_day(year[i % n_years], dayofyear[i % n_days]);
+        }
+        return julday;
+    });
+}
 
-    std::transform(year.begin(), year.end(), dayofyear.begin(),
-            ret.begin(), calc_julian_day);
-    return ret;
+SharedTimes universal_gmt(double interval, double tz) {
+    GridKey key(double_bits(interval), double_bits(tz));
+    return grid_cache.get(key, [=]() {
+        double seconds = interval * 60;
+        long step = (long) floor(seconds + 0.5);
+        if (!(interval <= 60) || step < 1 || fabs(seconds - step) > 1e-6) {
+            throw std::range_error("Interval must be between 1 second and 60 minutes, in whole seconds");
+        }
+        if (86400 % step != 0) {
+            throw std::range_error("Interval must divide a day into whole intervals");
+        }
+
+        // seconds since midnight are whole numbers, so exact, and the same hours
+        // as calculating from the hour and minute of each interval
+        int n = 86400 / step;
+        std::vector<double> hour(n);
+        for (int i = 0; i < n; ++i) {
+            hour[i] = (double) i * step / 3600 - tz;
+        }
+
+        return hour;
+    });
 }
 
-Rcpp::NumericVector universal_gmt(int interval, double tz) {
-    if (interval > 60 || interval < 1) {
-        throw std::range_error("Interval must be between 1 and 60");
+std::vector<TimeRun> grid_runs(const std::vector<double> &julday,
+                               Rcpp::NumericVector dayofyear,
+                               const std::vector<double> &universaltime) {
+    int n = universaltime.size();
+    int n_days = dayofyear.size();
+    if (n_days == 0) return std::vector<TimeRun>();
+    int n_julday = julday.size();
+    std::vector<TimeRun> runs(n_julday);
+
+    for (int d = 0; d < n_julday; ++d) {
+        TimeRun run = {julday[d], dayofyear[d % n_days], (long) d * n, n,
+                       d % n_days, universaltime.data()};
+        runs[d] = run;
     }
+    return runs;
+}
 
-    int n = 1440 / interval; // 60 * 24 = 1440 minutes/day
-    int step = 60 / interval;
-
-    // using iota gives a speed increase
-    // since this function returns a fixed length no matter what,
-    // the speed increase isn't really worth it
-    Rcpp::IntegerVector unique_hours = Rcpp::seq_len(24);
-    unique_hours = unique_hours - 1;
-
-    // faster than using rep_len
-    Rcpp::NumericVector hour(n);
+// Year and day of year of the given day since 1970-01-01, in the proleptic
+// Gregorian calendar. From Howard Hinnant's chrono-compatible date algorithms.
+static void civil_day(long days, long *year, long *dayofyear) {
+    long z = days + 719468;
+    long era = (z >= 0 ? z : z - 146096) / 146097;
+    long doe = z - era * 146097;
+    long yoe = (doe - doe/1460 + doe/36524 - doe/146096) / 365;
+    long doy = doe - (365*yoe + yoe/4 - yoe/100);   // days since March 1st
+    long mp = (5*doy + 2) / 153;
+    long y = yoe + era * 400 + (mp >= 10);
+
+    // days since 1970-01-01 of January 1st of year y
+    long yp = y - 1;
+    long era1 = (yp >= 0 ? yp : yp - 399) / 400;
+    long yoe1 = yp - era1 * 400;
+    long jan1 = era1 * 146097 + yoe1*365 + yoe1/4 - yoe1/100 + 306 - 719468;
+
+    *year = y;
+    *dayofyear = days - jan1 + 1;
+}
 
-    auto it = unique_hours.begin();
-    for (auto i = hour.begin(); i != hour.end(); i += step, ++it) {
-        std::fill(i, i + step, *it);
+std::vector<TimeRun> time_runs(Rcpp::NumericVector time, double tz,
+                               std::vector<double> &utime) {
+    long n = time.size();
+    utime.resize(n);
+    std::vector<TimeRun> runs;
+
+    long day = 0;
+    for (long i = 0; i < n; ++i) {
+        if (ISNAN(time[i])) {
+            utime[i] = NA_REAL;
+            TimeRun run = {NA_REAL, NA_REAL, i, 1, i, utime.data() + i};
+            runs.push_back(run);
+            continue;
+        }
+
+        // seconds since local midnight, as on the universal_gmt grid
+        double local = time[i] + tz * 3600;
+        double local_day = floor(local / 86400);
+        utime[i] = (local - local_day * 86400) / 3600 - tz;
+
+        bool same_day = !runs.empty() && runs.back().first + runs.back().n == i &&
+                        !ISNAN(runs.back().julday) && (long) local_day == day;
+        if (same_day) {
+            ++runs.back().n;
+            continue;
+        }
+
+        long year, dayofyear;
+        day = (long) local_day;
+        civil_day(day, &year, &dayofyear);
+        TimeRun run = {calc_julian_day(year, dayofyear), (double) dayofyear, i, 1, i,
+                       utime.data() + i};
+        runs.push_back(run);
     }
+    return runs;
+}
 
-    Rcpp::IntegerVector unique_minutes = Rcpp::seq_len(60);
-    unique_minutes = unique_minutes - 1;
-    Rcpp::NumericVector minute;
-    minute = rep(unique_minutes, n);
-
-    // overwrite hour instead of creating a new return vector
-    std::transform(hour.begin(), hour.end(), minute.begin(), hour.begin(),
-        [tz](double h, double m) { return (h*3600 + m*60)/3600 - tz; }
-    );
+ZenithMethod zenith_method(bool vectorized, bool fast) {
+    if (vectorized && fast)
+        throw std::range_error("vectorized and fast can't both be TRUE");
+    return vectorized ? ZENITH_VECTORIZED : (fast ? ZENITH_FAST : ZENITH_EXACT);
+}
 
-    return hour;
+void zenith_run(const TimeRun &run, const Location &loc, ZenithMethod method, double *z) {
+    if (ISNAN(run.julday)) {
+        std::fill(z, z + run.n, NA_REAL);
+    } else if (method == ZENITH_VECTORIZED) {
+        solar_zenith_vectorized(run.julday, run.utime, run.n, loc, z);
+    } else if (method == ZENITH_FAST) {
+        solar_zenith_fast(run.julday, run.utime, run.n, loc, z);
+    } else {
+        for (long t = 0; t < run.n; ++t) {
+            z[t] = solar_zenith(solar_ephemeris(run.julday, run.utime[t]), loc);
+        }
+    }
 }
 
-void setnum(Rcpp::NumericVector &x, double c) {
-    std::transform(x.begin(), x.end(), x.begin(),
-            [c](double a) {
-                a = a - c * floor(a/c);
-                if (a < 0) {
-                    return a + c;
-                } else {
-                    return a;
-                }
-            });
+// Zenith angles at loc for each point of the runs, n in total.
+static SEXP zenith_runs(const std::vector<TimeRun> &runs, long n, const Location &loc,
+                        ZenithMethod method, bool float32) {
+    SeriesWriter out(n, float32);
+    for (const TimeRun &run : runs) {
+        zenith_run(run, loc, method, out.block(run.first, run.n));
+    }
+    return out.result();
 }
 
 //' Calculate the zenith angle.
@@ -87,11 +193,38 @@ void setnum(Rcpp::NumericVector &x, double c) {
 //' @param longitude Longitude of the location at which the zenith angle is to
 //' be calculated.
 //' @param interval Number of minutes between zenith angle calculations. Defaults to
-//' (every minute). Must be an integer between 1 and 60, inclusive.
+//' (every minute). May be from 1 second (1/60) to 60 minutes, in whole seconds
+//' that divide a day evenly, e.g. 0.5 for every 30 seconds.
+//' @param vectorized If TRUE, calculate the zenith angles with vectorized
+//' approximations of the trigonometric functions. Angles differ from the
+//' default calculation by less than 1e-10 degrees.
+//' @param fast If TRUE, calculate the declination and right ascension of the
+//' sun only at whole hours, and interpolate them between hours with a cubic.
+//' Angles differ from the default calculation by less than 1e-9 degrees, far
+//' below what detection can tell apart. At intervals of a few minutes or
+//' less, they are calculated about three times as fast. May not be combined
+//' with vectorized.
+//' @param float32 If TRUE, return the values as 32 bit floats, taking half the
+//' memory. See \code{\link{as_float32}}.
+//' @param profile If TRUE, time the stages of the calculation, returned in
+//' attribute 'profile' of the result.
+//' @param compact If TRUE, return a compact series, whose angles are only
+//' calculated when read, a day at a time. Reading a few days calculates only
+//' those days, and the whole series is calculated and kept once it is read
+//' in full, for instance by arithmetic. Needs R 3.6.0 or later, see
+//' \code{\link{compact_supported}}. May not be combined with float32.
 //'
 //' @return A single vector of the zenith angles at each interval throughout the
 //' specified time period
-//' (i.e. a vector of length (60 * 24 / interval) * number of days).
+//' (i.e. a vector of length (60 * 24 / interval) * number of days). If
+//' float32 is TRUE, the vector is stored in a raw vector of class 'float32'.
+//'
+//' If profile is TRUE, attribute 'profile' is a list of seconds, the wall
+//' clock seconds of each stage: setup, building the time grid, and zenith,
+//' calculating the angles; points and days, the number of angles and of days
+//' calculated; and bytes, the bytes allocated for the time grid and the
+//' result. Compact angles aren't calculated, so the zenith stage just builds
+//' the series, and the bytes don't include its angles.
 //'
 //' @details
 //' zenith is vectorized over both dayofyear and year, with the shorter vector
@@ -99,110 +232,252 @@ void setnum(Rcpp::NumericVector &x, double c) {
 //'
 //' @keywords internal
 // [[Rcpp::export]]
-Rcpp::NumericVector zenith(Rcpp::NumericVector dayofyear, Rcpp::NumericVector year,
-                           double tz, double latitude, double longitude,
-                           int interval = 1) {
-    double const deg2rad = M_PI/180;
-    double const rad2deg = 180/M_PI;
-
-    Rcpp::NumericVector universaltime = universal_gmt(interval, tz);
-    Rcpp::NumericVector julday = julian_day(dayofyear, year);
+SEXP zenith(Rcpp::NumericVector dayofyear, Rcpp::NumericVector year,
+            double tz, double latitude, double longitude,
+            double interval = 1, bool vectorized = false, bool float32 = false,
+            bool profile = false, bool compact = false, bool fast = false) {
+    if (compact && float32)
+        throw std::range_error("compact series can't be float32");
+    ZenithMethod method = zenith_method(vectorized, fast);
+
+    StageTimes times;
+    SharedTimes universaltime = universal_gmt(interval, tz);
+    SharedTimes julday = julian_day(dayofyear, year);
 
     // to vectorize over dayofyear and year,
-    // create a copy of universaltime for each julday
-    int n = universaltime.size();
-    Rcpp::NumericVector ecliptic_time = Rcpp::rep_each(julday, n);
-    Rcpp::NumericVector utime = Rcpp::rep_len(universaltime, ecliptic_time.size());
-
-    // Time used in the calculation of ecliptic coordinates
-    ecliptic_time = ecliptic_time + utime / 24;
-    ecliptic_time = ecliptic_time - 51545;
-
-    // Mean longitude, all values between 0 and 360
-    Rcpp::NumericVector meanlong = 280.46 + 0.9856474 * ecliptic_time;
-    setnum(meanlong, 360.0);
-
-    // Mean anomaly
-    Rcpp::NumericVector meananom = 357.528 + 0.9856003 * ecliptic_time;
-    setnum(meananom, 360.0);
-    meananom = meananom * deg2rad; // radians
-
-    // Ecliptic longitude
-    Rcpp::NumericVector eclipticlong = meanlong + 1.915 * Rcpp::sin(meananom) + 0.02 * Rcpp::sin(2*meananom);
-    setnum(eclipticlong, 360.0);
-    eclipticlong = eclipticlong * deg2rad; // radians
-
-    // Obliquity of the ecliptic
-    Rcpp::NumericVector eclipticobli = 23.439 - 0.0000004 * ecliptic_time;
-    eclipticobli = eclipticobli * deg2rad; // radians
-
-    // Declination
-    // declin is only ever used in the context of deg2rad * declin
-    // but removing both rad2deg and deg2rad later causes (slight) numerical differences from R
-    // when calculating ETR solar zenith angle
-    // no idea why...
-    // but leave in (even though they should cancel out)
-    Rcpp::NumericVector declin = rad2deg * Rcpp::asin( Rcpp::sin(eclipticobli) * Rcpp::sin(eclipticlong) );
-
-    // Right ascension
-    // single pass, avoid creating vectors for top and bottom
-    Rcpp::NumericVector rascen(eclipticlong.size());
-    std::transform(eclipticlong.begin(), eclipticlong.end(), eclipticobli.begin(), rascen.begin(),
-            [rad2deg](double eclong, double ecobli) {
-                double top = cos(ecobli) * sin(eclong);
-                double bottom = cos(eclong);
-                double rightascen = rad2deg * atan2(top, bottom);
-
-                // ensure angle is positive
-                if (rightascen < 0) {
-                    return rightascen + 360.0;
-                } else {
-                    return rightascen;
-                }
-            });
-
-    // Greenwich mean sidereal time
-    Rcpp::NumericVector gmst = 6.697375 + 0.0657098242 * ecliptic_time + utime;
-    setnum(gmst, 24.0);
-
-    // Local mean sidereal time
-    Rcpp::NumericVector lmst = gmst * 15 + longitude;
-    setnum(lmst, 360.0);
-
-    // Hour angle, between -180 and 180 degrees
-    Rcpp::NumericVector hour_angle = lmst - rascen;
-    std::transform(hour_angle.begin(), hour_angle.end(), hour_angle.begin(),
-            [](double a) {
-                if (a < -180) {
-                    return a + 360;
-                } else if (a > 180) {
-                    return a - 360;
-                } else {
-                    return a;
-                }
-            });
-
-    // ETR solar zenith angle
-    Rcpp::NumericVector sd = Rcpp::sin(deg2rad * declin);
-    Rcpp::NumericVector cd = Rcpp::cos(deg2rad * declin);
-    Rcpp::NumericVector ch = Rcpp::cos(deg2rad * hour_angle);
-    Rcpp::NumericVector cz = sd * sin(deg2rad * latitude) + cd * cos(deg2rad * latitude) * ch;
-
-    // cos of zenith must be between -1 and 1
-    std::replace_if(cz.begin(), cz.end(),
-            [](double a) { return a < -1; },
-            -1);
-    std::replace_if(cz.begin(), cz.end(),
-            [](double a) { return a > 1; },
-            1);
-
-    Rcpp::NumericVector zenetr = Rcpp::acos(cz) * rad2deg;
-
-    // limit the degrees below the horizon to 90
-    std::replace_if(zenetr.begin(), zenetr.end(),
-            [](double a) { return a > 90; },
-            90);
+    // calculate every universaltime for each julday.
+    // each angle is calculated in a single pass, writing directly to the
+    // return vector, rather than building a vector per intermediate term
+    std::vector<TimeRun> runs = grid_runs(*julday, dayofyear, *universaltime);
+    long n = (long) julday->size() * universaltime->size();
+    if (profile) times.end("setup");
+
+    Location loc(latitude, longitude);
+    Rcpp::RObject result;
+    if (compact) {
+        result = compact_series(runs, universaltime->data(), universaltime->size(), n,
+                                [loc, method](const TimeRun &run, double *z) {
+                                    zenith_run(run, loc, method, z);
+                                });
+    } else {
+        result = zenith_runs(runs, n, loc, method, float32);
+    }
+    if (!profile) return result;
+    times.end("zenith");
+
+    // float32 angles are buffered as doubles a day at a time, and compact
+    // series keep copies of the runs and times
+    double bytes = (double) (universaltime->size() + julday->size()) * sizeof(double) +
+        (double) runs.size() * sizeof(TimeRun);
+    if (compact) {
+        bytes += (double) runs.size() * sizeof(TimeRun) +
+            (double) universaltime->size() * sizeof(double);
+    } else if (float32) {
+        bytes += (double) n * FLOAT32_SIZE + universaltime->size() * sizeof(double);
+    } else {
+        bytes += (double) n * sizeof(double);
+    }
+    result.attr("profile") = Rcpp::List::create(
+        Rcpp::Named("seconds") = times.result(),
+        Rcpp::Named("points") = (double) n,
+        Rcpp::Named("days") = (double) julday->size(),
+        Rcpp::Named("bytes") = bytes);
+    return result;
+}
+
+//' Calculate the zenith angle at given times.
+//'
+//' @param time Times at which to calculate the zenith angle, either POSIXct
+//' or seconds since 1970-01-01 UTC.
+//' @inheritParams zenith
+//'
+//' @return A vector of the zenith angle at each time, NA for NA times. Times
+//' on the grid of \code{\link{zenith}} give exactly the same angles.
+//'
+//' @details
+//' tz only decides the local day of each time, and is needed for the angles
+//' to match those of zenith exactly.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+SEXP zenith_times(Rcpp::NumericVector time, double tz, double latitude,
+                  double longitude, bool vectorized = false, bool float32 = false,
+                  bool fast = false) {
+    std::vector<double> utime;
+    std::vector<TimeRun> runs = time_runs(time, tz, utime);
+    return zenith_runs(runs, time.size(), Location(latitude, longitude),
+                       zenith_method(vectorized, fast), float32);
+}
+
+//' Calculate the time dependent terms of the solar position.
+//'
+//' The terms of the zenith angle calculation that depend only on time are
+//' calculated once, and may then be used to calculate the zenith angles at
+//' any number of locations with \code{\link{zenith_ephemeris}}.
+//'
+//' @inheritParams zenith
+//'
+//' @return An external pointer of class 'solar_ephemeris'. The pointer is not
+//' valid after being saved and reloaded.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::XPtr<EphemerisTable> ephemeris(Rcpp::NumericVector dayofyear,
+                                     Rcpp::NumericVector year, double tz,
+                                     double interval = 1) {
+    SharedTimes universaltime = universal_gmt(interval, tz);
+    SharedTimes julday = julian_day(dayofyear, year);
+
+    Rcpp::XPtr<EphemerisTable> table(
+        new EphemerisTable(julday->data(), julday->size(), universaltime->data(),
+                           universaltime->size()));
+    table.attr("class") = "solar_ephemeris";
+    return table;
+}
+
+// The table held by an ephemeris external pointer.
+const EphemerisTable &as_ephemeris(Rcpp::XPtr<EphemerisTable> &ephemeris) {
+    if (!ephemeris.inherits("solar_ephemeris")) {
+        throw std::range_error("ephemeris must be created by ephemeris()");
+    }
+    if (ephemeris.get() == NULL) {
+        throw std::range_error("ephemeris is no longer valid, it must be recreated");
+    }
+    return *ephemeris;
+}
 
+//' Calculate the zenith angle from precalculated solar position terms.
+//'
+//' @param ephemeris Solar position terms created by \code{\link{ephemeris}}.
+//' @param latitude Latitude of the location at which the zenith angle is to
+//' be calculated.
+//' @param longitude Longitude of the location at which the zenith angle is to
+//' be calculated.
+//'
+//' @return The same vector of zenith angles as \code{\link{zenith}} for the
+//' days, tz and interval of the ephemeris.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::NumericVector zenith_ephemeris(Rcpp::XPtr<EphemerisTable> ephemeris,
+                                     double latitude, double longitude) {
+    const EphemerisTable &table = as_ephemeris(ephemeris);
+
+    Rcpp::NumericVector zenetr(table.terms.size());
+    solar_zenith(table.terms.data(), table.terms.size(),
+                 Location(latitude, longitude), zenetr.begin());
     return zenetr;
 }
 
+//' Calculate the zenith angles at many sites.
+//'
+//' The time dependent terms of the solar position are calculated once for
+//' each distinct time zone, and shared between the sites in it.
+//'
+//' @inheritParams zenith
+//' @param tz UTC offsets of the sites. Either a single offset shared by all
+//' sites, or one per site.
+//' @param latitude Numeric vector of the latitudes of the sites.
+//' @param longitude Numeric vector of the longitudes of the sites, the same
+//' length as latitude.
+//' @param threads Number of threads to calculate the angles on. The sites are
+//' split into one contiguous range per thread.
+//'
+//' @return A matrix with one column per site, each column containing the same
+//' angles as \code{\link{zenith}} for that site.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::NumericMatrix zenith_batch(Rcpp::NumericVector dayofyear,
+                                 Rcpp::NumericVector year,
+                                 Rcpp::NumericVector tz,
+                                 Rcpp::NumericVector latitude,
+                                 Rcpp::NumericVector longitude,
+                                 double interval = 1, int threads = 1) {
+    int n_sites = latitude.size();
+
+    if (longitude.size() != n_sites)
+        throw std::range_error("latitude must be the same length as longitude");
+    if (tz.size() != 1 && tz.size() != n_sites)
+        throw std::range_error("tz must have length 1 or the same length as latitude");
+    if (threads <= 0)
+        throw std::range_error("threads must be a positive integer");
+    int n_times = universal_gmt(interval, 0)->size();
+
+    SharedTimes julday = julian_day(dayofyear, year);
+
+    // one table of time only terms per distinct time zone
+    std::map<double, EphemerisTable> tables;
+    std::vector<const EphemerisTable *> site_table(n_sites);
+    for (int s = 0; s < n_sites; ++s) {
+        double site_tz = tz[tz.size() == 1 ? 0 : s];
+        auto it = tables.find(site_tz);
+        if (it == tables.end()) {
+            SharedTimes universaltime = universal_gmt(interval, site_tz);
+            EphemerisTable table(julday->data(), julday->size(),
+                                 universaltime->data(), universaltime->size());
+            it = tables.insert(std::make_pair(site_tz, table)).first;
+        }
+        site_table[s] = &it->second;
+    }
+
+    long n_angles = (long) julday->size() * n_times;
+    Rcpp::NumericMatrix zenetr(n_angles, n_sites);
+    double *out = zenetr.begin();
+    const double *lat = latitude.begin();
+    const double *lon = longitude.begin();
+
+    auto site_zenith = [&](int s) {
+        solar_zenith(site_table[s]->terms.data(), n_angles,
+                     Location(lat[s], lon[s]), out + s * n_angles);
+    };
+
+    int chunk_len = (n_sites + threads - 1) / threads;
+    int n_chunks = chunk_len > 0 ? (n_sites + chunk_len - 1) / chunk_len : 0;
+
+    if (n_chunks <= 1) {
+        for (int s = 0; s < n_sites; ++s) {
+            site_zenith(s);
+            Rcpp::checkUserInterrupt();
+        }
+    } else {
+        run_parallel(n_chunks, [&](int t, const std::atomic<bool> &cancel) {
+            int last = std::min((t + 1) * chunk_len, n_sites);
+            for (int s = t * chunk_len; s < last && !cancel; ++s) {
+                site_zenith(s);
+            }
+        });
+    }
+
+    return zenetr;
+}
+
+//' Statistics of the time caches.
+//'
+//' The universal times of each interval and time zone, and the julian days
+//' of each dayofyear and year, are cached between calls of \code{\link{zenith}}
+//' and the models, keeping the 16 grids and 64 sets of julian days most
+//' recently used.
+//'
+//' @param clear If TRUE, empty the caches after reading their statistics.
+//'
+//' @return A matrix with a row for each cache, grid and julian_day, and
+//' columns hits and misses, the number of lookups found and not found in the
+//' cache, and size, the number of entries it holds.
+//'
+//' @keywords internal
+// [[Rcpp::export]]
+Rcpp::NumericMatrix time_cache_stats(bool clear = false) {
+    Rcpp::NumericMatrix stats(2, 3);
+    grid_cache.stats(&stats(0, 0), &stats(0, 1), &stats(0, 2));
+    julian_cache.stats(&stats(1, 0), &stats(1, 1), &stats(1, 2));
+    stats.attr("dimnames") = Rcpp::List::create(
+        Rcpp::CharacterVector::create("grid", "julian_day"),
+        Rcpp::CharacterVector::create("hits", "misses", "size"));
+
+    if (clear) {
+        grid_cache.clear();
+        julian_cache.clear();
+    }
+    return stats;
+}
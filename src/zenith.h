@@ -0,0 +1,102 @@
+#ifndef CLEARSKIES_ZENITH_H
+#define CLEARSKIES_ZENITH_H
+
+#include <memory>      // shared_ptr
+#include <vector>
+#include <Rcpp.h>
+#include "float32.h"
+#include "solar.h"
+
+// Time series construction shared by the zenith angle and model exports,
+// defined in zenith.cpp.
+
+double calc_julian_day(double year, double dayofyear);
+
+// Times shared with the caches of julian_day and universal_gmt, which stay
+// valid for as long as they are held. The caches keep the most recently used
+// times of the process, and are safe to use from any thread.
+typedef std::shared_ptr<const std::vector<double> > SharedTimes;
+
+// Julian day of each dayofyear and year, with the shorter vector recycled.
+SharedTimes julian_day(const Rcpp::NumericVector &dayofyear, const Rcpp::NumericVector &year);
+
+// Universal time, in hours, of each interval throughout a day in time zone tz.
+// interval is in minutes, and must be a whole number of seconds.
+SharedTimes universal_gmt(double interval, double tz);
+
+// Consecutive points of a series on the same local day.
+struct TimeRun {
+    double julday;
+    double dayofyear;
+    long first;             // index of the first point in the series
+    long n;
+    long element;           // element of dayofyear or time that the run is from
+    const double *utime;    // universal time of each point, in hours
+};
+
+// One run per julian day, each of every universal time.
+std::vector<TimeRun> grid_runs(const std::vector<double> &julday,
+                               Rcpp::NumericVector dayofyear,
+                               const std::vector<double> &universaltime);
+
+// Runs of time, in seconds since 1970-01-01 UTC, on the same day in time zone
+// tz. The universal time of each point is written to utime, which the runs
+// point into. Universal times are the same as universal_gmt for times on its
+// grid. NA times are runs of their own, with NA julian day.
+std::vector<TimeRun> time_runs(Rcpp::NumericVector time, double tz,
+                               std::vector<double> &utime);
+
+// How zenith angles are calculated: exactly, with the vectorized
+// approximations, or interpolating the time only terms between hours.
+enum ZenithMethod { ZENITH_EXACT, ZENITH_VECTORIZED, ZENITH_FAST };
+
+// The method chosen by the vectorized and fast arguments of the exports, at
+// most one of which may be true.
+ZenithMethod zenith_method(bool vectorized, bool fast);
+
+// Zenith angles at loc of each point of run, written to z, or NA if the
+// julian day of the run is NA.
+void zenith_run(const TimeRun &run, const Location &loc, ZenithMethod method, double *z);
+
+// Values of a series written a block at a time, returned as a numeric
+// vector, or float32 if float32 is true. float32 blocks are packed once the
+// next block is started, so the series is never held as doubles.
+class SeriesWriter {
+public:
+    SeriesWriter(long n, bool float32)
+        : float32_(float32), values_(float32 ? 0 : n),
+          packed_(float32 ? n * FLOAT32_SIZE : 0), first_(0) {}
+
+    // Buffer for the n values starting at first, valid until the next block.
+    double *block(long first, long n) {
+        flush();
+        first_ = first;
+        if (!float32_) return values_.begin() + first;
+        buffer_.resize(n);
+        return buffer_.data();
+    }
+
+    SEXP result() {
+        flush();
+        if (!float32_) return values_;
+        packed_.attr("class") = "float32";
+        return packed_;
+    }
+
+private:
+    bool float32_;
+    Rcpp::NumericVector values_;
+    Rcpp::RawVector packed_;
+    std::vector<double> buffer_;
+    long first_;
+
+    void flush() {
+        if (float32_ && !buffer_.empty()) {
+            pack_float32(buffer_.data(), buffer_.size(),
+                         packed_.begin() + first_ * FLOAT32_SIZE);
+        }
+        buffer_.clear();
+    }
+};
+
+#endif